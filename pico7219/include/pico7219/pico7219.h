@@ -19,10 +19,13 @@
   "bottom-left" corner is (0,0) although, of course, the display modules
   can be rotated so this might be the top right in some installations.
 
-  At present, this library doesn't have a way to set the display module to
-  stand-by mode, except by calling pico7219_destroy() to tidy it up.
-  Since entering stand-by requires reinitializing the hardware, this
-  is probably (but not definitely) the right approach.
+  Calling pico7219_destroy() leaves the modules in their low-power 
+  shutdown mode. While the display is in use, pico7219_set_idle() turns
+  on an idle mode, in which a flush that would send nothing new is 
+  skipped, and a completely dark frame puts the modules into shutdown
+  rather than sending it. The modules keep their data in shutdown, so
+  waking them on the next lit frame only needs the rows that changed,
+  and no reinitialization.
 
   The library supports the notion of a "virtual" chain of display
   modules. When LEDs are turned on and off, they are written to this
@@ -32,12 +35,56 @@
   first set, but content that won't fit can be scrolled into view by
   calling pico7219_scroll repeatedly. 
 
+  Individual modules in the chain can also be configured to drive
+  7-segment displays, using pico7219_configure_module(). In that case
+  each "row" of the module is one digit, and pico7219_display_number()
+  and pico7219_display_string() format text directly into the digit
+  registers, using the MAX7219's built-in Code B decoder where 
+  possible. 
+
+  Applications that cannot use the heap can create the object with
+  pico7219_init_static() instead of pico7219_create(), passing in 
+  storage for the object and all its buffers. PICO7219_STATIC_SIZE()
+  gives the amount of storage needed, and PICO7219_STATIC_STORAGE()
+  declares a suitably-aligned array of that size.
+
+  Any pixel can be made to blink, by setting its bit in the blink 
+  attribute plane with pico7219_set_blink() or pico7219_set_blink_rect(),
+  and setting a blink period with pico7219_set_blink_period(). 
+  Blinking is applied as the data is flushed, so the application 
+  doesn't need to redraw anything, but it does have to flush at least
+  twice per period. When the phase changes, only rows with blinking 
+  pixels are sent. Blink attributes move with the image when it is
+  scrolled.
+
+  Several displays can share one SPI channel, each with its own 
+  chip-select pin. Create a bus with pico7219_bus_create(), which 
+  initializes the SPI channel once, and then create the displays with
+  pico7219_create_on_bus(). pico7219_bus_flush() flushes all the 
+  displays on a bus together, in turn or in order of priority.
+
+  The display can be split into zones, each of which shows its own 
+  part of the virtual chain through a viewport that can be moved, or 
+  scrolled at a steady speed, independently of the others -- a fixed
+  label on the first modules, say, with a message scrolling past on 
+  the rest. Zones are assembled row by row as the display is flushed,
+  so moving a viewport copies no data, and the content of a zone that
+  isn't moving is never redrawn. See pico7219_zone_create().
+
+  None of the drawing functions is safe to call from an interrupt 
+  handler while the main program might be using the library. Interrupt 
+  handlers should use pico7219_isr_set_pixel() instead, which queues 
+  the change without blocking. Queued changes are applied at the start
+  of the next flush, so a flush always sends a complete, consistent 
+  frame.
+
   Copyright (c)2021 Kevin Boone, GPL v3.0
 
   =========================================================================*/
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #if PICO_ON_DEVICE
 #include "hardware/spi.h"
 #endif 
@@ -63,6 +110,29 @@ typedef uint8_t BOOL;
 #define PICO7219_ROWS 8
 #define PICO7219_COLS 8
 
+// Number of bytes reserved for the library's own data structure, when
+//   it is created in caller-provided storage. The library checks at
+//   compile time that this is large enough.
+#define PICO7219_OBJECT_SIZE 512
+
+// Number of bytes of storage needed by pico7219_init_static(), for
+//   a physical chain of chain_len modules and a virtual chain of
+//   vchain_len modules. The virtual chain buffer is never made smaller
+//   than the physical chain, and there are two planes of it: the 
+//   pixels, and the blink attributes.
+#define PICO7219_STATIC_SIZE(chain_len, vchain_len) \
+  (PICO7219_OBJECT_SIZE + 2 * PICO7219_ROWS * \
+    ((vchain_len) > (chain_len) ? (vchain_len) : (chain_len)))
+
+// Number of pixel updates from interrupt handlers that can be waiting
+//   for the next flush. Must be a power of two. 
+#define PICO7219_ISR_QUEUE 32
+
+// Declare an array suitable for passing to pico7219_init_static(). 
+//   Use it as "static PICO7219_STATIC_STORAGE (my_storage, 4, 16);"
+#define PICO7219_STATIC_STORAGE(name, chain_len, vchain_len) \
+  uint64_t name[(PICO7219_STATIC_SIZE (chain_len, vchain_len) + 7) / 8]
+
 // An enum to denote the SPI channel to use. This is to avoid exposing
 //   client classes to the low-level API provided by the Pico SDK
 enum PicoSpiNum 
@@ -71,7 +141,38 @@ enum PicoSpiNum
   PICO_SPI_1
   };
 
+// The kind of display attached to a particular module in the chain. 
+//   See pico7219_configure_module().
+enum Pico7219ModuleMode
+  {
+  PICO7219_MODE_MATRIX = 0,
+  PICO7219_MODE_DIGITS
+  };
+
+// A pixel position, for pico7219_set_pixels()
+struct Pico7219Point
+  {
+  uint16_t col;
+  uint8_t row;
+  };
+
+// Maximum number of displays that can share one SPI bus
+#define PICO7219_BUS_MAX_DISPLAYS 8
+
+// The order in which pico7219_bus_flush() sends the displays on a bus 
+enum Pico7219BusOrder
+  {
+  // Each display takes its turn at being sent first
+  PICO7219_BUS_ROUND_ROBIN = 0,
+  // Highest priority first. See pico7219_set_priority()
+  PICO7219_BUS_PRIORITY
+  };
+
+// Maximum number of zones on one display. See pico7219_zone_create()
+#define PICO7219_MAX_ZONES 4
+
 struct Pico7219;
+struct Pico7219Bus;
 
 #ifdef __cplusplus
 extern "C" { 
@@ -88,11 +189,66 @@ extern struct Pico7219 *pico7219_create (enum PicoSpiNum spi_num,
 			   uint8_t sck, uint8_t cs, uint8_t chain_len,
 			   BOOL reverse_bits);
 
+/** pico7219_init_static() -- as pico7219_create(), but the object and
+    all its buffers are placed in the storage supplied by the caller, 
+    and the heap is never used. The storage must be at least 
+    PICO7219_STATIC_SIZE (chain_len, vchain_len) bytes, and aligned 
+    to eight bytes; PICO7219_STATIC_STORAGE() declares an array that
+    meets both requirements. vchain_len is the initial length of the
+    virtual chain. Returns NULL if the storage is unsuitable, or
+    chain_len is larger than PICO7219_MAX_CHAIN. The storage must 
+    remain valid until pico7219_destroy() is called, which does not 
+    attempt to free it. */
+extern struct Pico7219 *pico7219_init_static (void *storage, 
+                           size_t storage_size, enum PicoSpiNum spi_num, 
+                           int32_t baud, uint8_t mosi, uint8_t sck, 
+                           uint8_t cs, uint8_t chain_len, int vchain_len,
+			   BOOL reverse_bits);
+
 /** Clean up the library. If "deinit" is TRUE, the corresponding SPI
     channel in the Pico is deinitialized. In either case, set the 
-    display hardware to the low-power standby mode. */
+    display hardware to the low-power standby mode. A display created
+    on a shared bus is removed from the bus, and the SPI channel is 
+    left alone, whatever the value of deinit. */
 extern void             pico7219_destroy (struct Pico7219 *self, BOOL deinit);
 
+/** Create a bus: an SPI channel that several displays can share, each
+    with its own chip-select pin. The SPI channel and the data and clock
+    pins are initialized here, once. Returns NULL if there is not 
+    enough memory. */
+extern struct Pico7219Bus *pico7219_bus_create (enum PicoSpiNum spi_num, 
+                           int32_t baud, uint8_t mosi, uint8_t sck);
+
+/** Clean up a bus. Any displays still on the bus are destroyed. If 
+    deinit is TRUE, the SPI channel is deinitialized. */
+extern void pico7219_bus_destroy (struct Pico7219Bus *bus, BOOL deinit);
+
+/** As pico7219_create(), but the display uses the SPI channel of a bus,
+    and only the chip-select pin is initialized. Returns NULL if the 
+    bus already has PICO7219_BUS_MAX_DISPLAYS displays, or there is not
+    enough memory. Use pico7219_destroy() to tidy up, as usual. */
+extern struct Pico7219 *pico7219_create_on_bus (struct Pico7219Bus *bus,
+                           uint8_t cs, uint8_t chain_len, 
+                           BOOL reverse_bits);
+
+/** Set the priority of a display on a bus, for buses in 
+    PICO7219_BUS_PRIORITY order. Higher priorities are flushed first.
+    The default is 0. */
+extern void pico7219_set_priority (struct Pico7219 *self, uint8_t priority);
+
+/** Set the order in which pico7219_bus_flush() sends the displays. The
+    default is PICO7219_BUS_ROUND_ROBIN. */
+extern void pico7219_bus_set_order (struct Pico7219Bus *bus, 
+                           enum Pico7219BusOrder order);
+
+/** Flush all the displays on a bus. The changes in every display are 
+    worked out before anything is sent, so that the displays' 
+    transactions follow each other on the bus without a gap. A display
+    on a bus can still be flushed on its own with pico7219_flush(). 
+    Like the other functions, this must not be called from two cores 
+    at once. */
+extern void pico7219_bus_flush (struct Pico7219Bus *bus);
+
 /** Write a whole row in one operation. The bits[] argument is an array
     of bytes, where each byte represents a set of on/off states in
     specific columns. bits[0] represents the module at the end of
@@ -119,6 +275,25 @@ extern void             pico7219_switch_on (struct Pico7219 *self,
 extern void             pico7219_switch_off (struct Pico7219 *self, 
                           uint8_t row, uint8_t col, BOOL flush);
 
+/** Turn the LED at a particular row and column on or off. This is
+    pico7219_switch_on() or pico7219_switch_off(), but the column is an
+    int, so it can reach every column of a virtual chain more than 256
+    pixels long. Positions outside the virtual chain, including 
+    negative ones, are ignored. */
+extern void             pico7219_set_pixel (struct Pico7219 *self, 
+                          int row, int col, BOOL on, BOOL flush);
+
+/** Turn on, or off, the LEDs at n positions of the virtual chain. This
+    is much faster than calling pico7219_switch_on() for each pixel:
+    the positions are checked against the virtual chain once, before 
+    any are drawn, and if all are valid the pixels are set without 
+    further checks. Otherwise positions outside the virtual chain are 
+    skipped. The rows that were drawn in are marked for the next flush,
+    and if flush is TRUE the display is flushed once, at the end. */
+extern void pico7219_set_pixels (struct Pico7219 *self, 
+                          const struct Pico7219Point *pts, int n, 
+                          BOOL on, BOOL flush);
+
 /** Turn off all the LEDs in a row. If flush is TRUE,
     changes are written immediately to the hardware. Otherwise they are
     buffered for a later call to flush(). */
@@ -138,16 +313,178 @@ extern void pico7219_switch_on_row (struct Pico7219 *self, uint8_t row,
 
 /** Turn on all the LEDs in the display. If the module is powered by
     USB, the supply might not be adequate to switch on all LEDs at
-    high intensity. */
+    high intensity. See pico7219_set_current_limit(). */
 extern void pico7219_switch_on_all (struct Pico7219 *self, BOOL flush);
 
+/** Set all the LEDs in one column of the virtual chain. Bit 0 of 
+    bits is the state of the LED in row 0, and so on. Only rows that
+    actually change are marked for the next flush. If flush is TRUE,
+    changes are written immediately to the hardware. */
+extern void pico7219_set_column (struct Pico7219 *self, int col, 
+                          uint8_t bits, BOOL flush);
+
+/** Turn on (or off) all the LEDs in a rectangle of the virtual chain,
+    w columns wide and h rows high, with its lowest-numbered corner at
+    column x and row y. Parts that fall outside the virtual chain are
+    ignored. Each row is filled a byte at a time, not a pixel at a 
+    time. */
+extern void pico7219_fill_rect (struct Pico7219 *self, int x, int y, 
+                          int w, int h, BOOL on, BOOL flush);
+
+/** Draw a bar graph of n vertical bars, starting at column x of the 
+    virtual chain. Each bar is bar_width columns wide, and there are
+    gap blank columns after each bar. heights[i] is the number of LEDs
+    lit in bar i, counting up from row 0, in the range 0-8. Every 
+    column in the bar area is overwritten, including the gaps. The
+    rows are built a whole module at a time, and only rows that 
+    change are marked for the next flush. This function is intended
+    for level meters and spectrum displays that are redrawn many times
+    a second. */
+extern void pico7219_draw_bars (struct Pico7219 *self, int x, 
+                          const uint8_t *heights, int n, int bar_width,
+                          int gap, BOOL flush);
+
+/** Replace a whole row of the virtual chain. bits[] must contain one 
+    byte for each module in the virtual chain, in the same layout that 
+    the library uses internally: bit 0 of bits[0] is column 0. The row
+    is marked for the next flush only if it changes. */
+extern void pico7219_set_row (struct Pico7219 *self, uint8_t row, 
+                          const uint8_t *bits, BOOL flush);
+
+/** Get a pointer to the library's own data for a row of the virtual
+    chain, which has one byte for each virtual module, laid out as 
+    for pico7219_set_row(). This is for clients that need to draw 
+    directly into the buffer. The pointer is only valid until the 
+    next scroll or change of virtual chain length. After changing the
+    data, call pico7219_mark_row_dirty(), or the change might not be
+    flushed. */
+extern uint8_t *pico7219_get_row_buffer (struct Pico7219 *self, 
+                          uint8_t row);
+
+/** As pico7219_get_row_buffer(), for the blink attribute plane, which
+    has the same layout. This is for clients that move the image in 
+    the virtual chain themselves, and must move the blink attributes 
+    with it. Returns NULL if no pixel in the row has ever been made to 
+    blink, in which case there is nothing to move. Use 
+    pico7219_set_blink() to set attributes. */
+extern uint8_t *pico7219_get_blink_row_buffer (struct Pico7219 *self, 
+                          uint8_t row);
+
+/** Mark a row to be written to the hardware at the next flush. */
+extern void pico7219_mark_row_dirty (struct Pico7219 *self, uint8_t row);
+
+/** Get the contents of a row of the physical display, as it was at the
+    last flush, in the same layout as pico7219_set_row_bits(). bits[] 
+    must have room for PICO7219_MAX_CHAIN bytes. */
+extern void pico7219_get_display_row (const struct Pico7219 *self, 
+                          uint8_t row, uint8_t bits[PICO7219_MAX_CHAIN]);
+
+/** Get the number of modules in the physical chain. */
+extern uint8_t pico7219_get_chain_length (const struct Pico7219 *self);
+
+/** Get the number of modules in the virtual chain. */
+extern int pico7219_get_virtual_chain_length (const struct Pico7219 *self);
+
+/** Get the time in microseconds from some arbitrary starting point. This
+    is the clock the library uses for its own timing. */
+extern uint64_t pico7219_time_us (void);
+
+/** Turn one LED on or off from an interrupt handler, or from a thread 
+    or core other than the one that flushes the display. The change is
+    put in a lock-free queue, and applied to the virtual chain at the 
+    start of the next flush (or pico7219_isr_apply()). This never 
+    blocks or waits. Returns TRUE if the change was queued, or FALSE if
+    the queue was full, in which case the change is dropped. A position
+    outside the virtual chain is queued, but ignored when it is 
+    applied. Only one producer may use this function at a time -- that
+    is, one interrupt priority level, or one other core. Changes are 
+    applied in the order they were queued, after any changes made by 
+    the main program before the flush. */
+extern BOOL pico7219_isr_set_pixel (struct Pico7219 *self, uint8_t row, 
+                          uint16_t col, BOOL on);
+
+/** Apply the changes queued by pico7219_isr_set_pixel() to the virtual
+    chain, without flushing. Call this only from the main program. */
+extern void pico7219_isr_apply (struct Pico7219 *self);
+
+/** Make the pixel at a particular row and column blink, or stop it
+    blinking. Blinking only shows if a blink period has been set. */
+extern void pico7219_set_blink (struct Pico7219 *self, uint8_t row, 
+      int col, BOOL blink);
+
+/** As pico7219_set_blink(), for a rectangle. Parts of the rectangle
+    outside the virtual chain are ignored. */
+extern void pico7219_set_blink_rect (struct Pico7219 *self, int x, int y,
+      int w, int h, BOOL blink);
+
+/** Stop all pixels blinking. */
+extern void pico7219_clear_blink (struct Pico7219 *self);
+
+/** Set the time for one complete on-off cycle of blinking pixels, in
+    microseconds. They are dark for the second half of the cycle. 0, 
+    the default, turns blinking off, and blinking pixels are shown 
+    normally. The phase is checked at each flush. */
+extern void pico7219_set_blink_period (struct Pico7219 *self, 
+      uint32_t period_us);
+
 /** Write buffered LED state changes to the hardware. */
 extern void pico7219_flush (struct Pico7219 *self);
 
+/** Enable or disable idle mode, for displays whose content is often 
+    static or blank. In idle mode, a flush sends nothing if no row is 
+    dirty, or if a hash of the frame shows it to be the same as the 
+    last one sent; a frame with no LEDs lit puts the chain into 
+    shutdown, with a single transaction, instead of sending it. The next
+    flush of a lit frame sends the rows that have changed and then
+    switches the chain back on. Background refresh steps are skipped 
+    along with the rest of a skipped flush. Idle mode is off by 
+    default. */
+extern void pico7219_set_idle (struct Pico7219 *self, BOOL idle);
+
+/** Enable or disable background refresh. MAX7219 modules can lose their
+    settings, or their data, after an electrical glitch. With refresh
+    enabled, each call to pico7219_flush() also re-sends one of the 
+    control registers, or one row of data as it was last flushed, 
+    taking turns. So the whole chain is brought back into step within
+    13 flushes, at the cost of one extra transaction per flush. While
+    idle mode has shut the chain down, refresh keeps it shut down.
+    Refresh is disabled by default. */
+extern void pico7219_set_refresh (struct Pico7219 *self, BOOL refresh);
+
+/** Carry out the next step of background refresh immediately, whether
+    or not refresh is enabled. Applications that don't flush regularly
+    can call this from a timer, instead. */
+extern void pico7219_refresh_step (struct Pico7219 *self);
+
 /** Set the LED brightness in the range 0-15. Default is 1. Note that
  * there is no "off" setting -- even 0 has some illumination. */
 extern void pico7219_set_intensity (struct Pico7219 *self, uint8_t intensity);
 
+/** As pico7219_set_intensity(), but the change is made by the next 
+    flush, in the same burst as the row data. If background refresh is
+    enabled, the intensity write takes the place of that flush's 
+    refresh step, so the change costs no extra transaction. Only the 
+    last value set before the flush is written. */
+extern void pico7219_set_intensity_deferred (struct Pico7219 *self, 
+      uint8_t intensity);
+
+/** Limit the current drawn by the display, by reducing the intensity
+    when too many LEDs are lit. The budget is expressed as the number
+    of LEDs that may be lit at full intensity (15); at lower intensities
+    proportionally more may be lit. On each flush, the library counts
+    the LEDs that will be lit, and lowers the intensity as far as 
+    necessary, but never above the value set by 
+    pico7219_set_intensity(). Any change of intensity is written as
+    part of the same flush. If per_module is FALSE, the budget applies
+    to the whole chain, and all modules get the same intensity. If it
+    is TRUE, the budget applies to each module separately, and each
+    module's intensity is limited separately. Digit modules are not
+    counted. Intensity can't be reduced below zero, so a budget that
+    is too small will be exceeded at intensity 0. A budget of 0 
+    removes the limit. */
+extern void pico7219_set_current_limit (struct Pico7219 *self, 
+      uint16_t budget, BOOL per_module);
+
 /** Scroll the virtual module chain one pixel (LED) to the left. The part
       of the virtual chain that fits on the display will be shown. If
       wrap is TRUE, pixels that are scrolled off the display are redrawn
@@ -160,6 +497,77 @@ extern void pico7219_set_intensity (struct Pico7219 *self, uint8_t intensity);
       Don't ask for it if you don't want it. */
 extern void pico7219_scroll (struct Pico7219 *self, BOOL wrap);
 
+/** Scroll the whole display one pixel (row) up, that is, towards higher
+      row numbers. If wrap is TRUE, the top row reappears at the bottom;
+      otherwise the bottom row is cleared. The rows are not copied --
+      the library just changes which row of data it displays in each
+      row of LEDs -- so this takes the same time however long the
+      virtual chain is. The result is written to the hardware 
+      immediately. */
+extern void pico7219_scroll_up (struct Pico7219 *self, BOOL wrap);
+
+/** Scroll the whole display one pixel (row) down, that is, towards 
+      lower row numbers. See pico7219_scroll_up(). */
+extern void pico7219_scroll_down (struct Pico7219 *self, BOOL wrap);
+
+/** Scroll the virtual module chain dx pixels to the left and dy pixels
+      up, and then write the whole result to the hardware in a single
+      flush. Negative values scroll right or down. The wrap argument 
+      has the same meaning as for pico7219_scroll(), in both 
+      directions. */
+extern void pico7219_scroll_by (struct Pico7219 *self, int dx, int dy, 
+      BOOL wrap);
+
+/** Move the content of the virtual chain, exactly as 
+      pico7219_scroll_by(), but without writing to the hardware. All
+      rows are marked for the next flush. */
+extern void pico7219_move (struct Pico7219 *self, int dx, int dy, 
+      BOOL wrap);
+
+/** Create a zone: display columns first_col to first_col + width - 1
+      show columns src_col to src_col + src_width - 1 of the virtual
+      chain, the source, through a viewport that starts at the first
+      column of the source. Columns that are in no zone show the 
+      virtual chain as usual, so a fixed label needs no zone of its 
+      own: it can be drawn at the start of the virtual chain, with the
+      source of a scrolling zone drawn beyond the end of the display.
+      Zones should not overlap; where they do, the one created last is
+      shown. Returns the number of the new zone, which the other zone
+      functions take as an argument, or -1 if the zone doesn't fit the
+      display, or the source doesn't fit the virtual chain, or there
+      are already PICO7219_MAX_ZONES zones. The zone is shown from the
+      next flush. Zone sources are part of the virtual chain, so 
+      pico7219_scroll() and pico7219_move() move them too. */
+extern int pico7219_zone_create (struct Pico7219 *self, int first_col, 
+      int width, int src_col, int src_width);
+
+/** Move a zone's viewport, so that column offset of its source is 
+      shown in the zone's first column. Columns of the zone beyond 
+      either end of the source are dark, unless the zone wraps, in 
+      which case the source repeats endlessly. */
+extern void pico7219_zone_set_offset (struct Pico7219 *self, int zone, 
+      int offset, BOOL flush);
+
+/** Get the current viewport offset of a zone. */
+extern int pico7219_zone_get_offset (const struct Pico7219 *self, 
+      int zone);
+
+/** Scroll a zone steadily, at speed columns per second; positive 
+      speeds move the content to the left. Each flush moves the 
+      viewport by however many columns are due, so the speed doesn't 
+      depend on how often the application flushes. A speed of 0 stops
+      the zone. If wrap is TRUE, the source repeats endlessly; 
+      otherwise the zone stops when the source has scrolled completely
+      out of view. To scroll a message in from the right, set the 
+      offset to minus the width of the zone first. Other zones, and 
+      columns in no zone, are not affected. */
+extern void pico7219_zone_set_scroll (struct Pico7219 *self, int zone, 
+      int speed, BOOL wrap);
+
+/** Remove all zones, so the display shows the virtual chain as 
+      usual. */
+extern void pico7219_zone_clear_all (struct Pico7219 *self);
+
 /** Set the number of "virtual modules" in the display chain. This can be
       any length (subject to memory), but it makes little sense to set
       this smaller than the actual display. The purpose of setting the
@@ -169,10 +577,46 @@ extern void pico7219_scroll (struct Pico7219 *self, BOOL wrap);
       the predefined maximum physical chain length, that is, 8 modules. 
       If you don't plan to use the scrolling function, you can save a
       little memory by setting the virtual chain length to the actual
-      chain length. But we're talking bytes here. */
-extern void pico7219_set_virtual_chain_length (struct Pico7219 *self, 
+      chain length. But we're talking bytes here. 
+    If the object was created by pico7219_init_static(), the new
+      virtual chain must fit into the storage originally supplied.
+    Returns FALSE if there is not enough memory, in which case the
+      existing virtual chain is left as it was. Otherwise the virtual
+      chain is cleared. */
+extern BOOL pico7219_set_virtual_chain_length (struct Pico7219 *self, 
    int chain_len);
 
+/** Configure a single module in the chain. Module 0 is the module
+      nearest the input, as for pico7219_set_row_bits(). mode is
+      PICO7219_MODE_MATRIX for an 8x8 LED matrix (the default), or
+      PICO7219_MODE_DIGITS for a 7-segment display. Data for a digit
+      module is never bit-reversed. decode is the MAX7219 decode-mode
+      register, one bit per digit, with a 1 meaning Code B. scan_limit 
+      is the number of digits, less one, in the range 0-7. The settings
+      are written to the hardware immediately. */
+extern void pico7219_configure_module (struct Pico7219 *self, 
+      uint8_t module, enum Pico7219ModuleMode mode, uint8_t decode,
+      uint8_t scan_limit);
+
+/** Show a decimal number on a 7-segment module, right-aligned, with
+      a leading minus sign if negative. If the number doesn't fit
+      the module's scan limit, all digits show a dash. The module's
+      decode mode is set to Code B for all digits. Only digits whose
+      value changes are marked for the next flush. */
+extern void pico7219_display_number (struct Pico7219 *self, 
+      uint8_t module, int32_t value, BOOL flush);
+
+/** Show a string on a 7-segment module, left-aligned and truncated to
+      the number of digits in the scan limit. A '.' is shown as the 
+      decimal point of the preceding character. Digits, spaces, '-' and
+      the letters E, H, L and P use the chip's Code B decoder; other
+      letters are approximated using raw segment patterns, and anything
+      else is blank. The decode mode is changed only if the mix of
+      Code B and raw digits changes. Only digits whose value changes
+      are marked for the next flush. */
+extern void pico7219_display_string (struct Pico7219 *self, 
+      uint8_t module, const char *s, BOOL flush);
+
 #ifdef __cplusplus
 } 
 #endif
@@ -0,0 +1,220 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219.hpp
+
+  A header-only C++ wrapper for the Pico7219 library. This needs C++20,
+  for std::span.
+
+  The geometry of the display -- physical chain length, virtual chain
+  length and bit order -- is fixed at compile time, as template 
+  arguments, so all the sizes are constants and the loops in the 
+  drawing and scrolling functions can be unrolled by the compiler.
+  The object holds its own storage, and uses pico7219_init_static(),
+  so it never uses the heap; declare it as a global or static object,
+  or on the stack if there is room. The display is shut down when the
+  object goes out of scope. There are no virtual functions.
+
+  The framebuffer -- the library's virtual chain -- can be accessed a 
+  row at a time as a std::span. Using the non-const row() function
+  marks the row for the next flush, whether or not it is changed.
+
+  The underlying C object is available from get(), for functions 
+  that are not wrapped. Don't use it to change the virtual chain
+  length, because this class relies on it being VirtualLen.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <pico7219/pico7219.h>
+
+namespace pico7219
+{
+
+/** Whether the column order in each module must be reversed. This 
+    depends on how the LED matrix is wired, as for the reverse_bits
+    argument to pico7219_create(). */
+enum class Orientation : uint8_t
+  {
+  normal,
+  reversed
+  };
+
+namespace detail
+{
+/** Call f(std::integral_constant<size_t, i>) for each i from 0 to N-1, 
+    as a sequence of separate calls rather than a loop. */
+template <typename F, std::size_t... I>
+constexpr void unroll (F &&f, std::index_sequence<I...>)
+  {
+  (f (std::integral_constant<std::size_t, I>{}), ...);
+  }
+
+template <std::size_t N, typename F>
+constexpr void unroll (F &&f)
+  {
+  unroll (std::forward<F> (f), std::make_index_sequence<N>{});
+  }
+}
+
+template <uint8_t ChainLen, int VirtualLen = ChainLen, 
+          Orientation Orient = Orientation::normal>
+class Display
+  {
+  static_assert (ChainLen >= 1 && ChainLen <= PICO7219_MAX_CHAIN,
+    "ChainLen must be between 1 and PICO7219_MAX_CHAIN");
+  static_assert (VirtualLen >= 1, "VirtualLen must be at least 1");
+
+  public:
+    static constexpr int rows = PICO7219_ROWS;
+    static constexpr uint8_t chain_len = ChainLen;
+    static constexpr int virtual_len = VirtualLen;
+    static constexpr int width = PICO7219_COLS * ChainLen;
+    static constexpr int virtual_width = PICO7219_COLS * VirtualLen;
+    static constexpr std::size_t storage_size = 
+      PICO7219_STATIC_SIZE (ChainLen, VirtualLen);
+
+    using Row = std::span<uint8_t, VirtualLen>;
+    using ConstRow = std::span<const uint8_t, VirtualLen>;
+
+    /** Initialize the hardware, as pico7219_create(). Check ok() 
+        afterwards. */
+    Display (PicoSpiNum spi_num, int32_t baud, uint8_t mosi, uint8_t sck,
+             uint8_t cs) noexcept
+      : handle (pico7219_init_static (storage, sizeof (storage), spi_num,
+          baud, mosi, sck, cs, ChainLen, VirtualLen, 
+          Orient == Orientation::reversed))
+      {
+      }
+
+    /** Put the display into standby. The SPI channel is left 
+        initialized. */
+    ~Display ()
+      {
+      if (handle) pico7219_destroy (handle, FALSE);
+      }
+
+    // The C object points into its own storage, so can't be moved
+    Display (const Display &) = delete;
+    Display &operator= (const Display &) = delete;
+
+    bool ok () const noexcept { return handle != nullptr; }
+
+    Pico7219 *get () noexcept { return handle; }
+
+    /** Get a row of the virtual chain for writing, and mark it for the
+        next flush. */
+    Row row (uint8_t r) noexcept
+      {
+      pico7219_mark_row_dirty (handle, r);
+      return Row (pico7219_get_row_buffer (handle, r), VirtualLen);
+      }
+
+    /** Get a row of the virtual chain for reading. */
+    ConstRow row (uint8_t r) const noexcept
+      {
+      return ConstRow (pico7219_get_row_buffer (handle, r), VirtualLen);
+      }
+
+    /** Turn a single LED in the virtual chain on or off. Out-of-range
+        positions are ignored. */
+    void set (int r, int col, bool on) noexcept
+      {
+      if (r < 0 || r >= rows || col < 0 || col >= virtual_width) return;
+      uint8_t mask = 1 << (col % PICO7219_COLS);
+      uint8_t &b = row (r)[col / PICO7219_COLS];
+      b = on ? (b | mask) : (b & ~mask);
+      }
+
+    /** Turn all the LEDs off. */
+    void clear () noexcept
+      {
+      detail::unroll<rows> ([this] (auto r)
+        {
+        Row data = row (r);
+        detail::unroll<VirtualLen> ([&] (auto i) { data[i] = 0; });
+        });
+      }
+
+    /** Draw a bitmap given as an array of columns, in which bit 0 of 
+        each byte is the LED in row 0, starting at column x of the 
+        virtual chain. LEDs are only turned on, not off. Columns that
+        fall outside the virtual chain are ignored. */
+    void blit (int x, std::span<const uint8_t> columns) noexcept
+      {
+      uint8_t *data[rows];
+      detail::unroll<rows> ([&] (auto r) { data[r] = row (r).data (); });
+      for (std::size_t i = 0; i < columns.size (); i++)
+        {
+        int col = x + (int)i;
+        if (col < 0 || col >= virtual_width) continue;
+        uint8_t c = columns[i];
+        uint8_t mask = 1 << (col % PICO7219_COLS);
+        int block = col / PICO7219_COLS;
+        detail::unroll<rows> ([&] (auto r)
+          {
+          if (c & (1 << r)) data[r][block] |= mask;
+          });
+        }
+      }
+
+    /** Move the virtual chain one pixel to the left, with the blink
+        attributes, as pico7219_move (get(), 1, 0, wrap), but without
+        writing it to the hardware. */
+    void shift_left (bool wrap) noexcept
+      {
+      detail::unroll<rows> ([&] (auto r)
+        {
+        shift_row_left (row (r).data (), wrap);
+        uint8_t *blink = pico7219_get_blink_row_buffer (handle, r);
+        if (blink) shift_row_left (blink, wrap);
+        });
+      }
+
+    /** Scroll the virtual chain one pixel to the left, as 
+        pico7219_scroll(), and write it to the hardware. */
+    void scroll (bool wrap) noexcept
+      {
+      shift_left (wrap);
+      flush ();
+      }
+
+    /** Write buffered changes to the hardware. */
+    void flush () noexcept { pico7219_flush (handle); }
+
+    /** Set the LED brightness in the range 0-15. */
+    void set_intensity (uint8_t intensity) noexcept
+      {
+      pico7219_set_intensity (handle, intensity);
+      }
+
+  private:
+    /** Shift one row of VirtualLen bytes one pixel to the left. */
+    static void shift_row_left (uint8_t *data, bool wrap) noexcept
+      {
+      uint8_t first = data[0];
+      detail::unroll<VirtualLen> ([&] (auto i)
+        {
+        uint8_t next;
+        if constexpr (i + 1 < VirtualLen)
+          next = data[i + 1];
+        else
+          next = wrap ? first : 0;
+        data[i] = (data[i] >> 1) | (uint8_t)(next << 7);
+        });
+      }
+
+    PICO7219_STATIC_STORAGE (storage, ChainLen, VirtualLen);
+    Pico7219 *handle;
+  };
+
+} // namespace pico7219
+
@@ -0,0 +1,103 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_cost.h
+
+  A model of the time taken to update a Pico7219 display, for planning
+  the length of a chain, the baud rate and the kind of animation that
+  a display can manage, before building it. The model counts the
+  bytes and chip-select cycles that the library will produce, works 
+  out the time these take on the wire at the baud rate the Pico's SPI
+  divider can actually produce, and adds an estimate of the processor
+  time the library spends preparing the data.
+
+  The processor time figures are estimates for an RP2040 at the 
+  default 125MHz clock. At high baud rates they dominate, so they 
+  can be replaced with figures measured on the real hardware, using
+  pico7219_cost_measure_flush().
+
+  These functions use no display object, and can be used on the host.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pico7219/pico7219.h>
+
+// The clock that drives the SPI peripheral, in Hz
+#define PICO7219_COST_CLK_PERI 125000000
+
+// Estimated processor time, in nanoseconds: for each transaction 
+//   (chip-select, and starting and draining the SPI transfer), for 
+//   each byte of a transaction, for each byte of a transaction when 
+//   the bits are reversed, for each of the eight rows that every flush
+//   copies from the virtual chain, dirty or not, and for each byte so
+//   copied, and for each byte of the virtual chain moved by a 
+//   horizontal scroll
+#define PICO7219_COST_NS_TRANSACTION 1500
+#define PICO7219_COST_NS_BYTE 40
+#define PICO7219_COST_NS_REVERSE 30
+#define PICO7219_COST_NS_ROW 100
+#define PICO7219_COST_NS_COPY 20
+#define PICO7219_COST_NS_SHIFT 25
+
+// What a display does in one update
+struct Pico7219CostParams
+  {
+  uint8_t chain_len;
+  int vchain_len; // Only matters for horizontal scrolling
+  uint32_t baud; // As passed to pico7219_create()
+  BOOL reverse_bits; // As passed to pico7219_create()
+  int rows; // Number of rows that change in each flush, 0-8
+  BOOL refresh; // TRUE if background refresh is on
+  BOOL current_limit; // TRUE if a current limit is set
+  };
+
+// The predicted cost of one update
+struct Pico7219CostEstimate
+  {
+  uint32_t bytes; // Bytes sent on the SPI bus
+  uint32_t cs_cycles; // Chip-select cycles, that is, transactions
+  uint32_t wire_us; // Time the bus is busy
+  uint32_t cpu_us; // Processor time, not counting the time on the bus 
+  uint32_t total_us; 
+  uint32_t max_fps; // Updates per second, if nothing else is done
+  };
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Get the baud rate that the Pico's SPI divider produces when baud
+    is requested. This is the fastest rate it can manage that is no 
+    faster than baud, which can be a good deal slower. */
+extern uint32_t pico7219_cost_actual_baud (uint32_t baud);
+
+/** Estimate the cost of a flush in which params->rows rows have 
+    changed. A current limit is assumed to need the worst case of two
+    intensity transactions in every flush. */
+extern void pico7219_cost_flush (const struct Pico7219CostParams *params,
+      struct Pico7219CostEstimate *estimate);
+
+/** Estimate the cost of a scroll by one pixel, followed by a flush.
+    Scrolling usually changes every row, so params->rows is taken to 
+    be 8. Vertical scrolling moves no data, but horizontal scrolling
+    moves the whole virtual chain. */
+extern void pico7219_cost_scroll (const struct Pico7219CostParams *params,
+      BOOL horizontal, struct Pico7219CostEstimate *estimate);
+
+/** Measure the time a flush of "rows" changed rows actually takes on 
+    a display, averaged over "count" flushes, for comparison with the 
+    estimate. This marks rows dirty and flushes, so it rewrites the 
+    display with its current contents. Returns the time in 
+    microseconds. */
+extern uint32_t pico7219_cost_measure_flush (struct Pico7219 *display, 
+      int rows, int count);
+
+#ifdef __cplusplus
+} 
+#endif
+
@@ -0,0 +1,112 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_dl.h
+
+  Display lists for Pico7219 displays. A display list is a compact,
+  recorded sequence of drawing operations -- pixels, rectangles, 
+  bitmaps, text and scrolling -- held in a byte buffer provided by the
+  caller. It doesn't refer to the display, so one core, or a network
+  handler, can record a scene while the other core is drawing, and
+  then pass the buffer over a queue. Replaying the list applies all
+  the operations to the display in one pass, and flushes at most once,
+  so rows touched by several operations are sent only once.
+
+  A display list contains no pointers, so it can be copied or sent 
+  anywhere. Text is stored as UTF-8, and the font is supplied when
+  the list is replayed.
+
+  The format is a sequence of operations, each an opcode byte followed 
+  by its arguments. 16-bit arguments are little-endian. Coordinates
+  and scroll distances are signed; n, h and the flags are not.
+
+    PICO7219_DL_CLEAR
+    PICO7219_DL_PIXEL  x:16 y:8 on:8
+    PICO7219_DL_RECT   x:16 y:8 w:16 h:8 on:8
+    PICO7219_DL_BLIT   x:16 n:8 columns:n*8
+    PICO7219_DL_TEXT   x:16 n:8 utf8:n*8
+    PICO7219_DL_SCROLL dx:16 dy:8 wrap:8
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pico7219/pico7219.h>
+#include <pico7219/pico7219_font.h>
+
+// Opcodes
+#define PICO7219_DL_CLEAR 0x01
+#define PICO7219_DL_PIXEL 0x02
+#define PICO7219_DL_RECT 0x03
+#define PICO7219_DL_BLIT 0x04
+#define PICO7219_DL_TEXT 0x05
+#define PICO7219_DL_SCROLL 0x06
+
+// A display list being recorded. The fields can be read, but should
+//   only be changed by the functions below. The recorded list is the
+//   first "len" bytes of "buf".
+struct Pico7219DisplayList
+  {
+  uint8_t *buf;
+  uint16_t capacity;
+  uint16_t len;
+  BOOL overflow; // TRUE if any operation didn't fit
+  };
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Start recording a display list into buf, which has room for 
+    capacity bytes. */
+extern void pico7219_dl_init (struct Pico7219DisplayList *dl, uint8_t *buf,
+      uint16_t capacity);
+
+/** Empty the display list, so that the buffer can be used again. */
+extern void pico7219_dl_reset (struct Pico7219DisplayList *dl);
+
+/** The recording functions below add one operation each, with the 
+    same meaning as the corresponding library function. They return
+    FALSE, and set the overflow flag, if the operation doesn't fit,
+    in which case the list is unchanged. */
+
+/** As pico7219_switch_off_all(). */
+extern BOOL pico7219_dl_clear (struct Pico7219DisplayList *dl);
+
+/** As pico7219_switch_on() or pico7219_switch_off(). */
+extern BOOL pico7219_dl_pixel (struct Pico7219DisplayList *dl, int x, 
+      int y, BOOL on);
+
+/** As pico7219_fill_rect(). */
+extern BOOL pico7219_dl_rect (struct Pico7219DisplayList *dl, int x, 
+      int y, int w, int h, BOOL on);
+
+/** Draw n columns, as pico7219_set_column(), starting at column x. At
+    most 255 columns. */
+extern BOOL pico7219_dl_blit (struct Pico7219DisplayList *dl, int x, 
+      const uint8_t *columns, int n);
+
+/** As pico7219_draw_text(). At most 255 bytes of UTF-8. */
+extern BOOL pico7219_dl_text (struct Pico7219DisplayList *dl, int x, 
+      const char *s);
+
+/** As pico7219_move(). */
+extern BOOL pico7219_dl_scroll (struct Pico7219DisplayList *dl, int dx, 
+      int dy, BOOL wrap);
+
+/** Apply a recorded display list, of len bytes, to the display. font is
+    used for text operations, and may be NULL if there are none. If 
+    flush is TRUE, the display is flushed once, at the end. Returns
+    FALSE if the list is malformed, in which case the operations before
+    the error have been applied. */
+extern BOOL pico7219_dl_replay (struct Pico7219 *display, 
+      const uint8_t *buf, uint16_t len, const struct Pico7219Font *font,
+      BOOL flush);
+
+#ifdef __cplusplus
+} 
+#endif
+
@@ -0,0 +1,78 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_field.h
+
+  Text fields for Pico7219 displays: a row of fixed-width character 
+  cells, bound to a rectangle of the virtual chain. The field remembers
+  the text it last showed, so when new text is set, only the cells 
+  whose characters have changed are drawn again, and only rows whose
+  pixels actually change are marked for the next flush. This suits 
+  clocks and counters, where one or two characters change at a time.
+
+  Glyphs are centred in their cells, with the bottom row of the font,
+  row 0, on the bottom row of the rectangle, and are clipped to the 
+  cell and to the rectangle. A rectangle less than eight rows high 
+  shows only the lower rows of each glyph, so a field that is not the
+  full height of the display needs a font that fits it. Pixels of the
+  rectangle outside the glyphs are dark.
+  Nothing outside the rectangle is changed, so fields can sit beside 
+  other content, or beside each other.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pico7219/pico7219.h>
+#include <pico7219/pico7219_font.h>
+
+// Maximum number of cells in a field
+#define PICO7219_FIELD_MAX_CELLS 16
+
+// A text field. The fields should be treated as private.
+struct Pico7219Field
+  {
+  struct Pico7219 *display;
+  const struct Pico7219Font *font;
+  int x; // Left edge of the first cell
+  int y; // Bottom row of the rectangle, where row 0 of a glyph goes
+  uint8_t cell_width;
+  uint8_t cells;
+  uint8_t mask; // The rows of the rectangle, one bit per row
+  // The character in each cell, as last drawn; 0 for a blank cell
+  uint32_t text[PICO7219_FIELD_MAX_CELLS]; 
+  BOOL valid; // FALSE if the cells must all be drawn next time
+  };
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Initialize a field of "cells" cells, each cell_width pixels wide, 
+    occupying the rectangle with its lowest-numbered corner at column
+    x and row y, and h rows high, as for pico7219_fill_rect(). Row 0 
+    is the bottom of the display, so the rectangle covers rows y to
+    y + h - 1, from row y upwards. Nothing is drawn until the first 
+    call to pico7219_field_set(). */
+extern void pico7219_field_init (struct Pico7219Field *field, 
+      struct Pico7219 *display, const struct Pico7219Font *font,
+      int x, int y, int cells, int cell_width, int h);
+
+/** Show a UTF-8 string in the field, one character per cell. Characters
+    beyond the last cell are ignored, and cells beyond the end of the 
+    string are left blank. Only cells whose character has changed are
+    drawn. Returns the number of cells drawn. */
+extern int pico7219_field_set (struct Pico7219Field *field, const char *s,
+      BOOL flush);
+
+/** Make the next pico7219_field_set() draw every cell, for use when
+    something else may have drawn over the field. */
+extern void pico7219_field_invalidate (struct Pico7219Field *field);
+
+#ifdef __cplusplus
+} 
+#endif
+
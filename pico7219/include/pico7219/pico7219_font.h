@@ -0,0 +1,100 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_font.h
+
+  Proportional bitmap fonts for Pico7219 displays. Fonts are compiled 
+  on the build host, by the fontc tool, into a packed format that can
+  be drawn without any conversion at runtime: each glyph is stored as 
+  a run of column bytes, in which bit 0 is the LED in row 0, so each
+  byte can be passed straight to pico7219_set_column(). Blank columns
+  at each side of a glyph are trimmed off, and the font records the
+  spacing to add between glyphs instead.
+
+  To keep the index small, glyph offsets are stored as a 16-bit base
+  offset for each block of 16 glyphs, plus an 8-bit offset within the
+  block for each glyph. The width of a glyph is the difference between
+  its offset and that of the next one, so isn't stored at all. 
+
+  A font has a dense range of glyphs for consecutive character codes, 
+  usually printable ASCII, which are found by indexing. It can also 
+  have any number of extra glyphs for other Unicode characters in the
+  Basic Multilingual Plane -- accented letters, Cyrillic, symbols --
+  which are found by binary search in a sorted table of code points.
+  All the tables are const, so they stay in flash. Strings are UTF-8.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pico7219/pico7219.h>
+
+// Number of glyphs that share one entry in the block offset table
+#define PICO7219_FONT_BLOCK 16
+
+struct Pico7219Font
+  {
+  uint8_t first; // Character code of the first glyph
+  uint8_t count; // Number of glyphs
+  uint8_t spacing; // Blank columns after each glyph
+  uint8_t blank_width; // Width of a glyph with no columns, like space
+  uint16_t extra_count; // Number of glyphs outside the dense range
+  // Code points of the extra glyphs, in ascending order. The glyph
+  //   for extra_codes[i] is glyph number count + i.
+  const uint16_t *extra_codes;
+  // Offset into columns[] of the first glyph in each block of 
+  //   PICO7219_FONT_BLOCK glyphs. (count + extra_count) / 
+  //   PICO7219_FONT_BLOCK + 1 entries
+  const uint16_t *blocks;
+  // Offset of each glyph from the start of its block. count + 
+  //   extra_count + 1 entries, so that the width of the last glyph 
+  //   can be found 
+  const uint8_t *offsets;
+  const uint8_t *columns; // Packed glyph columns
+  };
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Decode one character from a UTF-8 string, and advance *s past it.
+    Returns 0 at the end of the string. Invalid or truncated sequences
+    return U+FFFD, the replacement character, and skip one byte, so
+    a bad string can never cause a read past its terminator. */
+extern uint32_t pico7219_utf8_next (const char **s);
+
+/** Look up the glyph for character c. Returns the number of columns in
+    the glyph, and sets *columns to point to them, or returns -1 if 
+    the font has no glyph for c. A glyph can have zero columns. */
+extern int pico7219_font_glyph (const struct Pico7219Font *font, 
+      uint32_t c, const uint8_t **columns);
+
+/** Get the width in pixels of character c, including the spacing 
+    after it. Characters that are not in the font are drawn as blanks
+    of the font's blank width. */
+extern int pico7219_font_char_width (const struct Pico7219Font *font, 
+      uint32_t c);
+
+/** Get the width in pixels of a UTF-8 string. */
+extern int pico7219_font_text_width (const struct Pico7219Font *font, 
+      const char *s);
+
+/** Draw character c with its left edge at column x of the virtual chain,
+    including the spacing after it. All eight rows of each column are
+    overwritten. Returns the width drawn. */
+extern int pico7219_draw_char (struct Pico7219 *display, 
+      const struct Pico7219Font *font, int x, uint32_t c);
+
+/** Draw a UTF-8 string with its left edge at column x of the virtual chain.
+    Returns the width drawn. If flush is TRUE, changes are written 
+    immediately to the hardware. */
+extern int pico7219_draw_text (struct Pico7219 *display, 
+      const struct Pico7219Font *font, int x, const char *s, BOOL flush);
+
+#ifdef __cplusplus
+} 
+#endif
+
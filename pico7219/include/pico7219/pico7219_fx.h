@@ -0,0 +1,87 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_fx.h
+
+  Transition effects for Pico7219 displays: brightness fades, wipes
+  and dissolves. An effect is started, and then advanced by one step
+  each time pico7219_fx_tick() is called -- usually once per frame, 
+  just before the application's own flush. A tick only changes the 
+  virtual chain and the pending intensity; it never flushes. So each
+  step is sent by the regular flush, in the same burst as any other
+  changes, and only rows that the step changed are sent. Intensity
+  changes are made with pico7219_set_intensity_deferred(), so with 
+  background refresh enabled they need no extra transactions either.
+
+  Wipes and dissolves change the visible part of the display -- the 
+  first pico7219_get_chain_length() modules of the virtual chain -- 
+  into a target image. The target is laid out like the virtual chain,
+  eight rows of pico7219_get_virtual_chain_length() bytes, and must 
+  remain valid until the transition has finished. If the virtual 
+  chain length is changed while a wipe or dissolve is running, the 
+  target no longer matches it, so the transition stops where it is. A
+  fade can run at the same time as a wipe or dissolve.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pico7219/pico7219.h>
+
+// Directions for pico7219_fx_wipe()
+enum Pico7219FxWipe
+  {
+  PICO7219_FX_WIPE_RIGHT = 0, // Column 0 first
+  PICO7219_FX_WIPE_LEFT, // Last column first
+  PICO7219_FX_WIPE_UP, // Row 0 first
+  PICO7219_FX_WIPE_DOWN // Row 7 first
+  };
+
+struct Pico7219Fx;
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Create the effects engine for a display. This precomputes the
+    random order in which a dissolve changes pixels, so uses a little
+    memory for each pixel of the physical display. Returns NULL if 
+    there is not enough memory. */
+extern struct Pico7219Fx *pico7219_fx_create (struct Pico7219 *display);
+
+/** Tidy up. This does not change the display. */
+extern void pico7219_fx_destroy (struct Pico7219Fx *self);
+
+/** Fade the intensity from "from" to "to", in equal steps over "ticks"
+    ticks: the next tick sets "from", and the one "ticks" ticks after 
+    it sets "to". Intensity is written only on ticks where it 
+    changes. */
+extern void pico7219_fx_fade (struct Pico7219Fx *self, uint8_t from, 
+      uint8_t to, int ticks);
+
+/** Wipe the display into the target image, changing "speed" columns,
+    or rows, on each tick. This replaces any wipe or dissolve already
+    running. */
+extern void pico7219_fx_wipe (struct Pico7219Fx *self, 
+      const uint8_t *target, enum Pico7219FxWipe direction, int speed);
+
+/** Dissolve the display into the target image, changing "speed" 
+    pixels, chosen at random, on each tick. This replaces any wipe or
+    dissolve already running. */
+extern void pico7219_fx_dissolve (struct Pico7219Fx *self, 
+      const uint8_t *target, int speed);
+
+/** Advance all running effects by one step. Returns TRUE if any 
+    effect is still running after this step. */
+extern BOOL pico7219_fx_tick (struct Pico7219Fx *self);
+
+/** Stop all effects where they are. */
+extern void pico7219_fx_stop (struct Pico7219Fx *self);
+
+#ifdef __cplusplus
+} 
+#endif
+
@@ -0,0 +1,104 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_gray.h
+
+  Grayscale rendering for Pico7219 displays, by temporal dithering.
+  The MAX7219 can only turn each LED on or off, with one intensity 
+  setting for the whole module. To show several levels of brightness,
+  the image is held as 2-4 binary "bit planes", and each plane is shown
+  for a time proportional to its weight: plane 0 for one tick, plane 1
+  for two ticks, and so on. If the ticks are fast enough, the eye 
+  averages the planes into a grayscale image.
+
+  The application must call pico7219_gray_tick() at a steady rate, 
+  usually from a repeating timer. A new plane is written to the display
+  only when the previous one has been shown for long enough, and only
+  rows that differ from the previous plane are sent. The library times
+  each of these flushes, so pico7219_gray_get_stats() can report the
+  fastest tick rate the display can keep up with.
+
+  The grayscale image has the same width as the virtual chain, and 
+  uses the virtual chain as its working space. If the virtual chain
+  length is changed, the image is resized to match at the next call
+  to pico7219_gray_set_pixel() or pico7219_gray_clear(), keeping the
+  pixels that still fit. Resizing allocates memory, so 
+  pico7219_gray_tick(), which may be called from an interrupt, never 
+  does it; it does nothing until the image has been resized. The 
+  image should not be mixed with other drawing, or with the current
+  limit, which would change the intensity from one plane to the 
+  next.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pico7219/pico7219.h>
+
+// Range of bit plane counts supported
+#define PICO7219_GRAY_MIN_DEPTH 2
+#define PICO7219_GRAY_MAX_DEPTH 4
+
+struct Pico7219Gray;
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Create a grayscale image for the display, with depth bit planes, 
+    and so 2^depth levels of brightness. Returns NULL if depth is out
+    of range, or there is not enough memory. */
+extern struct Pico7219Gray *pico7219_gray_create (struct Pico7219 *display,
+      uint8_t depth);
+
+/** Tidy up. This does not change the display. */
+extern void pico7219_gray_destroy (struct Pico7219Gray *self);
+
+/** Set the brightness of a pixel, in the range 0 to 2^depth - 1. */
+extern void pico7219_gray_set_pixel (struct Pico7219Gray *self, 
+      uint8_t row, int col, uint8_t level);
+
+/** Get the brightness of a pixel. */
+extern uint8_t pico7219_gray_get_pixel (const struct Pico7219Gray *self, 
+      uint8_t row, int col);
+
+/** Set all pixels to level 0. */
+extern void pico7219_gray_clear (struct Pico7219Gray *self);
+
+/** Advance the display by one tick. Call this at a steady rate. One
+    complete grayscale frame takes 2^depth - 1 ticks. This allocates no
+    memory, and can be called from a timer interrupt. */
+extern void pico7219_gray_tick (struct Pico7219Gray *self);
+
+/** Get timing statistics for the flushes carried out by 
+    pico7219_gray_tick(): the average and worst-case time for one 
+    plane change, in microseconds, and the highest tick rate, in Hz,
+    at which the worst-case plane change still fits into a single 
+    tick. The frame rate is that tick rate divided by 2^depth - 1. 
+    Any of the pointers may be NULL. */
+extern void pico7219_gray_get_stats (const struct Pico7219Gray *self, 
+      uint32_t *avg_us, uint32_t *max_us, uint32_t *max_tick_hz);
+
+/** Estimate the brightness of each LED of the physical display: run 
+    one complete frame, add up the number of ticks for which the 
+    library left each LED on, and store the result in levels[]. 
+    levels[] is indexed by row * width + column, where width is 8 times
+    the physical chain length. This is computed from the data the 
+    library sent, on the assumption that every tick takes the same 
+    time -- it observes nothing about the hardware, so it checks the 
+    plane schedule, not the actual light output. For a correct 
+    schedule, each entry equals the level set for that pixel. Whether
+    the hardware keeps up can be judged from pico7219_gray_get_stats(),
+    which is based on measured flush times. This is intended for 
+    checking the implementation, particularly in the host build; on 
+    the Pico it will disturb the display timing. */
+extern void pico7219_gray_estimate_levels (struct Pico7219Gray *self, 
+      uint8_t *levels);
+
+#ifdef __cplusplus
+} 
+#endif
+
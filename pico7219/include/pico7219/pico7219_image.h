@@ -0,0 +1,115 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_image.h
+
+  Bitmap images, sprite sheets and animation frames for Pico7219 
+  displays. Images are converted on the build host, by the imgc tool,
+  from PBM files into const tables already in the library's own layout:
+  each frame is eight rows, from row 0, of (width + 7) / 8 bytes, with
+  bit 0 of the first byte in the leftmost column. So drawing a frame 
+  needs no conversion, and the tables stay in flash. 
+
+  Frames can be stored run-length encoded, in which case they are 
+  decoded byte by byte straight into the virtual chain. The encoding
+  is a sequence of control bytes: a control byte c below 0x80 is 
+  followed by c + 1 literal bytes, and a control byte of 0x80 or more
+  by one byte that is repeated c - 0x7E times.
+
+  Animations can also be stored in a more compact container, in which 
+  most frames are stored as the difference from the frame before. Each
+  frame is a type byte (PICO7219_ANIM_KEY or PICO7219_ANIM_DELTA), a 
+  byte with one bit set for each row that is stored, and then the 
+  stored rows, each run-length encoded as above. A key frame replaces
+  the rows it stores; a delta frame is XORed into them, and only rows 
+  that change are stored at all. A player decodes the frames one row 
+  at a time straight from flash into the virtual chain, as they fall 
+  due, so an animation of any length plays in a fixed, small amount of 
+  RAM. The first frame is always a key frame.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pico7219/pico7219.h>
+
+// Flags for struct Pico7219Image
+#define PICO7219_IMAGE_RLE 0x01
+
+// Frame types in a struct Pico7219Animation
+#define PICO7219_ANIM_KEY 0x00
+#define PICO7219_ANIM_DELTA 0x01
+
+struct Pico7219Image
+  {
+  uint16_t width; // Width of each frame, in pixels
+  uint16_t frames; // Number of frames
+  uint8_t flags; 
+  // The frames, one after another
+  const uint8_t *data; 
+  // For run-length encoded images, the offset of each frame in data[],
+  //   with an extra entry for the end of the last frame. NULL otherwise.
+  const uint32_t *offsets;
+  };
+
+struct Pico7219Animation
+  {
+  uint16_t width; // Width of each frame, in pixels
+  uint16_t frames; // Number of frames
+  uint16_t frame_ms; // Time each frame is shown, if durations is NULL
+  // Time each frame is shown, in milliseconds, or NULL
+  const uint16_t *durations; 
+  const uint8_t *data; // The encoded frames, one after another
+  };
+
+// The state of an animation that is playing. The fields should be 
+//   treated as private.
+struct Pico7219AnimPlayer
+  {
+  struct Pico7219 *display;
+  const struct Pico7219Animation *anim;
+  int x; // Column of the left edge of the animation
+  BOOL loop; 
+  BOOL playing;
+  uint16_t frame; // The next frame to decode
+  const uint8_t *next; // Its data
+  uint64_t due_us; // When it is due to be shown
+  };
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Draw one frame of an image with its left edge at column x of the
+    virtual chain, which may be negative. Parts of the frame outside 
+    the virtual chain are clipped. Rows are marked for the next flush
+    only if they change. Returns the width of the frame, or -1 if there
+    is no such frame. */
+extern int pico7219_image_draw (struct Pico7219 *display, 
+      const struct Pico7219Image *image, int frame, int x, BOOL flush);
+
+/** Start playing an animation with its left edge at column x of the 
+    virtual chain. The first frame is drawn at the next call to 
+    pico7219_anim_update(). Since most frames only record what has 
+    changed, nothing else should draw over the animation while it 
+    plays. */
+extern void pico7219_anim_start (struct Pico7219AnimPlayer *player, 
+      struct Pico7219 *display, const struct Pico7219Animation *anim, 
+      int x, BOOL loop);
+
+/** Decode whatever frames have fallen due, according to the animation's
+    timing, and flush if flush is TRUE and anything changed. If the 
+    application has fallen behind, the frames it has missed are decoded
+    but not flushed. Call this regularly, as often as the shortest frame
+    time or more. Returns TRUE until an animation that doesn't loop has
+    shown its last frame for its full time. */
+extern BOOL pico7219_anim_update (struct Pico7219AnimPlayer *player, 
+      BOOL flush);
+
+#ifdef __cplusplus
+} 
+#endif
+
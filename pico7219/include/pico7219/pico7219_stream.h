@@ -0,0 +1,139 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_stream.h
+
+  A simple protocol for streaming frames to a Pico7219 display, for
+  example from a host PC over USB stdio. Frames are sent as either a 
+  keyframe, which contains every byte of the virtual chain, or as 
+  deltas, which contain only the bytes that changed. The decoder is 
+  fed bytes as they arrive, and writes each data byte straight into 
+  the library's framebuffer, so no frame buffer of its own is needed.
+  At the end of each frame the display is flushed, and only rows that
+  a delta actually changed are sent.
+
+  Frames are in the same layout as the virtual chain: eight rows, 
+  starting at row 0, of "width" bytes, where bit 0 of byte 0 is 
+  column 0. The encoder is plain C, so can be used on the host; the
+  stream7219 tool in tools/ uses it to stream PBM images.
+
+  Each frame is a sequence of packets, each a command byte followed by
+  its arguments:
+
+    'K' width           then 8 * width bytes   Keyframe
+    'R' row start n     then n bytes           Bytes start..start+n-1 
+                                                 of a row
+    'C' row index value                        A single byte
+    'E' sum1 sum2                              End of frame
+
+  sum1 and sum2 are two 8-bit running sums (Fletcher's checksum, 
+  modulo 256) of every byte of the frame up to and including the 'E'.
+
+  So that a receiver can find the start of a frame wherever it joins 
+  the stream, or after losing bytes, each frame is framed as in HDLC:
+  it is preceded and followed by a sync byte, 0x7E, which never occurs
+  within a frame. A 0x7E or 0x7D in the frame is sent as 0x7D followed 
+  by the byte XOR 0x20. Two sync bytes in a row are an empty frame, 
+  which is ignored.
+
+  The decoder writes data bytes into the framebuffer as they arrive, 
+  before the checksum is known, but flushes only when a frame ends 
+  with a good checksum and a sync byte. If a frame is damaged -- a bad
+  checksum, an unknown command, or a sync byte in the middle -- it is
+  dropped, and so are all the delta frames after it, until a complete
+  keyframe arrives, which overwrites whatever the damaged frame wrote.
+  The decoder never flushes that data itself; but any other flush 
+  before the keyframe, such as the application's own, or one made to 
+  blink pixels or scroll a zone, sends the framebuffer as it is, 
+  including part of a frame, damaged or not. So a damaged frame is 
+  never shown only if nothing else flushes the display while the 
+  stream is being decoded. A decoder starts in the same way, waiting 
+  for a keyframe, so the sender should send keyframes now and then if
+  the receiver can join a stream late, or if the link can lose data.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <pico7219/pico7219.h>
+
+#define PICO7219_STREAM_KEY 'K'
+#define PICO7219_STREAM_ROW 'R'
+#define PICO7219_STREAM_CELL 'C'
+#define PICO7219_STREAM_END 'E'
+
+// Framing bytes
+#define PICO7219_STREAM_SYNC 0x7E
+#define PICO7219_STREAM_ESC 0x7D
+#define PICO7219_STREAM_ESC_XOR 0x20
+
+// The largest encoded frame for a virtual chain of width modules: a
+//   keyframe and end packet in which every byte needs an escape, and 
+//   two sync bytes
+#define PICO7219_STREAM_MAX_FRAME(width) \
+  (2 + 2 * (5 + PICO7219_ROWS * (width)))
+
+// Decoder state. The fields should be treated as private.
+struct Pico7219StreamDecoder
+  {
+  struct Pico7219 *display;
+  uint8_t state;
+  BOOL escaped; // TRUE if the last byte was an escape
+  BOOL need_key; // TRUE if waiting for a keyframe, after damage
+  BOOL key; // TRUE if the current frame is a keyframe
+  uint8_t sum1, sum2; // Checksum of the current frame so far
+  uint8_t check1; // The first checksum byte received
+  uint8_t row;
+  uint8_t width; // Bytes in each row of the current packet
+  uint8_t key_width; // Width of the last keyframe
+  int index; // Position in the current row
+  int remaining; // Data bytes still to come in the current packet
+  uint32_t frames; // Statistics
+  uint32_t bytes;
+  uint32_t dropped;
+  };
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Initialize a decoder that writes to display. */
+extern void pico7219_stream_init (struct Pico7219StreamDecoder *dec, 
+      struct Pico7219 *display);
+
+/** Decode len bytes of the stream. Returns the number of frames 
+    completed and flushed during this call. */
+extern int pico7219_stream_feed (struct Pico7219StreamDecoder *dec, 
+      const uint8_t *buf, int len);
+
+/** Read whatever stream data is available on stdin, and decode it.
+    On the Pico this doesn't wait, so it can be called in the main loop.
+    In the host build it blocks until some input arrives, which suits
+    input from a pipe. Returns the number of frames completed, or -1 
+    at the end of input in the host build. */
+extern int pico7219_stream_poll_stdio (struct Pico7219StreamDecoder *dec);
+
+/** Get the number of frames shown, the number of bytes received, and
+    the number of frames dropped, because they were damaged or were 
+    deltas waiting for a keyframe. Any of the pointers may be NULL. */
+extern void pico7219_stream_get_stats (
+      const struct Pico7219StreamDecoder *dec, uint32_t *frames, 
+      uint32_t *bytes, uint32_t *dropped);
+
+/** Encode a frame. cur is the new frame, and prev the frame the 
+    decoder already has, both in the virtual chain layout with "width"
+    bytes per row. If prev is NULL, or a delta would be no smaller, 
+    a keyframe is written. The complete frame, with its checksum, 
+    escapes and sync bytes, goes into out, which must have room for 
+    PICO7219_STREAM_MAX_FRAME(width) bytes. Returns the number of 
+    bytes written. width must be at most 255. */
+extern int pico7219_stream_encode (const uint8_t *prev, const uint8_t *cur,
+      int width, uint8_t *out);
+
+#ifdef __cplusplus
+} 
+#endif
+
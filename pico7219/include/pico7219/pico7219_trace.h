@@ -0,0 +1,87 @@
+/*=========================================================================
+  
+  Pico7219
+
+  pico7219_trace.h
+
+  Event tracing, for finding out where the time goes. When the library
+  is built with PICO7219_TRACE defined (cmake -DPICO7219_TRACE=ON), 
+  the flush, row write, scroll, chip-select and initialization code 
+  record events -- a timestamp, the core, and a small value such as a
+  row number -- in a fixed-size ring in RAM for each core. Events can
+  be recorded from both cores, and from interrupt handlers. Only a
+  core's own code writes its ring, so the cores never wait for each
+  other; within a core, interrupts are masked for the two instructions
+  that claim a slot. No atomic read-modify-write is used, which the 
+  RP2040 does not have. When a ring is full, its oldest events are 
+  overwritten.
+
+  pico7219_trace_dump() writes the ring to stdout, which is USB or 
+  UART stdio on the Pico, in the Chrome trace event JSON format. Save
+  the output to a file, and open it with chrome://tracing or 
+  https://ui.perfetto.dev to see a timeline.
+
+  Without PICO7219_TRACE, the trace macros, and pico7219_trace_dump(),
+  expand to nothing, so tracing costs nothing at all.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#pragma once
+
+#include <stdint.h>
+
+// Number of events held for each core. Must be a power of two.
+#define PICO7219_TRACE_SIZE 512
+
+// The events that are traced
+enum Pico7219TraceEvent
+  {
+  PICO7219_TRACE_FLUSH = 0, // Value is the number of rows sent
+  PICO7219_TRACE_ROW, // Value is the row
+  PICO7219_TRACE_SCROLL, // Value is the horizontal distance
+  PICO7219_TRACE_CS, // Value is the new level of chip-select
+  PICO7219_TRACE_INIT, // Value is the number of modules
+  PICO7219_TRACE_EVENTS
+  };
+
+#ifdef PICO7219_TRACE
+
+#define PICO7219_TRACE_BEGIN(event, value) \
+  pico7219_trace_record ((event), 'B', (value))
+#define PICO7219_TRACE_END(event, value) \
+  pico7219_trace_record ((event), 'E', (value))
+#define PICO7219_TRACE_INSTANT(event, value) \
+  pico7219_trace_record ((event), 'i', (value))
+
+#ifdef __cplusplus
+extern "C" { 
+#endif
+
+/** Record an event. phase is 'B' for the beginning of a span of time,
+    'E' for the end, or 'i' for an instant. Use the macros above, 
+    rather than calling this directly. */
+extern void pico7219_trace_record (enum Pico7219TraceEvent event, 
+      char phase, int value);
+
+/** Write the events in the rings to stdout, as a Chrome trace JSON 
+    document, each core's oldest first. The rings are not cleared. */
+extern void pico7219_trace_dump (void);
+
+/** Discard all recorded events. */
+extern void pico7219_trace_clear (void);
+
+#ifdef __cplusplus
+} 
+#endif
+
+#else
+
+#define PICO7219_TRACE_BEGIN(event, value) ((void)0)
+#define PICO7219_TRACE_END(event, value) ((void)0)
+#define PICO7219_TRACE_INSTANT(event, value) ((void)0)
+#define pico7219_trace_dump() ((void)0)
+#define pico7219_trace_clear() ((void)0)
+
+#endif
+
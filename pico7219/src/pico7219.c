@@ -19,14 +19,53 @@
 #if PICO_ON_DEVICE
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
+#include "pico/time.h"
 #else
 #include <stdio.h> // For printf(). Don't need this in the Pico build
+#include <time.h> // For clock_gettime()
 #endif
 
 #include "pico7219/pico7219.h"
+#include "pico7219/pico7219_trace.h"
 
+#define PICO7219_DECODE_REG 0x09
 #define PICO7219_INTENSITY_REG 0x0A
+#define PICO7219_SCAN_LIMIT_REG 0x0B
 #define PICO7219_SHUTDOWN_REG 0x0C
+#define PICO7219_TEST_REG 0x0F
+
+// Number of steps in a complete background refresh: the five control
+//   registers, followed by the eight rows
+#define PICO7219_REFRESH_CONTROL_STEPS 5
+#define PICO7219_REFRESH_STEPS (PICO7219_REFRESH_CONTROL_STEPS + PICO7219_ROWS)
+
+// Bits of an entry in the interrupt update queue. See isr_set_pixel()
+#define PICO7219_ISR_ON 0x01
+#define PICO7219_ISR_ROW_SHIFT 8
+#define PICO7219_ISR_COL_SHIFT 16
+
+// Bytes in one transaction: a 16-bit word for each module in the chain
+#define PICO7219_TRANSACTION_MAX (2 * PICO7219_MAX_CHAIN)
+
+// Code B values that the MAX7219 decodes itself, when decode mode is on
+#define PICO7219_CODEB_MINUS 0x0A
+#define PICO7219_CODEB_BLANK 0x0F
+#define PICO7219_SEG_DP 0x80
+
+// A zone: a range of display columns that shows its own part of the 
+//   virtual chain, through a viewport that can move. See 
+//   pico7219_zone_create()
+struct Pico7219Zone
+  {
+  uint16_t first_col; // First display column of the zone
+  uint16_t width; // Display columns in the zone
+  uint16_t src_col; // First column of the source, in the virtual chain
+  uint16_t src_width; // Columns in the source
+  int32_t offset; // Source column shown in the zone's first column
+  int16_t speed; // Columns per second; positive moves the content left
+  BOOL wrap; // TRUE if the source repeats, rather than ending
+  uint32_t step_us; // Time of the last step of scrolling
+  };
 
 // An opaque data structure that holds the information relevant to the
 //   library. Users of the library do not see this, or need to. 
@@ -46,15 +85,112 @@ struct Pico7219
   //   space.
   uint8_t data[PICO7219_ROWS][PICO7219_MAX_CHAIN];
   uint8_t row_dirty [PICO7219_ROWS]; // TRUE for each row to be flushed
+  // Per-module settings, indexed in the same order as data[row][]. 
+  //   A module in PICO7219_MODE_DIGITS drives a 7-segment display, and
+  //   its data is never bit-reversed.
+  uint8_t module_mode[PICO7219_MAX_CHAIN];
+  uint8_t decode[PICO7219_MAX_CHAIN]; 
+  uint8_t scan_limit[PICO7219_MAX_CHAIN]; 
+  uint8_t intensity; // Last value set by pico7219_set_intensity()
+  // TRUE if the next flush should set the intensity to pending_intensity
+  BOOL intensity_pending;
+  uint8_t pending_intensity;
+  // Intensity of each module as last written to the hardware, which
+  //   may be lower than the value set, if the current limit is in use
+  uint8_t sent_intensity[PICO7219_MAX_CHAIN]; 
+  uint16_t current_budget; // 0 for no limit. See set_current_limit()
+  BOOL budget_per_module; 
+  BOOL refresh; // TRUE if flush() should do a step of background refresh
+  BOOL idle; // TRUE if idle mode is on. See pico7219_set_idle()
+  BOOL asleep; // TRUE if idle mode has put the chain into shutdown
+  BOOL frame_hash_valid; 
+  uint32_t frame_hash; // Hash of self->data as it was last sent 
+  uint8_t refresh_step; // Next step of background refresh
   uint8_t *vdata;
   // Length of the "virtual chain" of modules
   int vchain_len;
+  // The blink attribute plane, laid out exactly like vdata, and 
+  //   allocated with it. A set bit makes the pixel blink.
+  uint8_t *blink;
+  // Bit n is set if row n of the blink plane (counting from the start
+  //   of the plane, not from row_base) may have any bits set. 
+  uint8_t blink_rows;
+  uint32_t blink_period; // In microseconds; 0 if blinking is off
+  BOOL blink_off; // TRUE in the half of the period when blinking pixels
+                  //   are dark
+  // Number of bytes available at vdata, and at blink. This can be larger than 
+  //   PICO7219_ROWS * vchain_len, if the chain has been shortened
+  int vdata_capacity;
+  // The row of vdata that holds display row 0. Vertical scrolling 
+  //   just changes this value, rather than moving any data. Use
+  //   pico7219_vrow() to find the data for a particular display row.
+  uint8_t row_base;
+  // Pixel updates from interrupt handlers, waiting to be applied to 
+  //   vdata by the next flush. This is a single-producer, single-consumer
+  //   ring: only the interrupt handler writes isr_head, and only the 
+  //   main program writes isr_tail. Each is a free-running count, so
+  //   the ring is empty when they are equal.
+  uint32_t isr_queue[PICO7219_ISR_QUEUE];
+  uint32_t isr_head;
+  uint32_t isr_tail;
+  // TRUE if the object and its buffers live in storage provided by
+  //   the caller to pico7219_init_static(), and must never be freed
+  BOOL is_static;
+  // The bus this display shares with others, or NULL if it has the 
+  //   SPI channel to itself
+  struct Pico7219Bus *bus;
+  uint8_t priority; // See pico7219_set_priority()
+  struct Pico7219Zone zones[PICO7219_MAX_ZONES];
+  uint8_t zone_count;
+  };
+
+// An SPI channel shared by several displays, each with its own 
+//   chip-select. Only the bus initializes the SPI channel.
+struct Pico7219Bus
+  {
+  uint8_t spi_num;
+#if PICO_ON_DEVICE
+  spi_inst_t* spi;
+#endif
+  // The displays on the bus, in the order they were created
+  struct Pico7219 *displays[PICO7219_BUS_MAX_DISPLAYS];
+  int count;
+  enum Pico7219BusOrder order;
+  int next; // For round-robin order, the display to flush first
   };
 
+// If this fails, PICO7219_OBJECT_SIZE in the header needs to be increased
+_Static_assert (sizeof (struct Pico7219) <= PICO7219_OBJECT_SIZE,
+  "PICO7219_OBJECT_SIZE is too small");
+
+/** Get a pointer to the start of the virtual chain data for a particular
+    display row, taking account of vertical scrolling. */
+static inline uint8_t *pico7219_vrow (const struct Pico7219 *self, int row)
+  {
+  int vrow = (row + self->row_base) & (PICO7219_ROWS - 1);
+  return self->vdata + vrow * self->vchain_len;
+  }
+
+/** As pico7219_vrow(), but for the blink plane. */
+static inline uint8_t *pico7219_brow (const struct Pico7219 *self, int row)
+  {
+  int vrow = (row + self->row_base) & (PICO7219_ROWS - 1);
+  return self->blink + vrow * self->vchain_len;
+  }
+
+/** TRUE if a display row may have blinking pixels. */
+static inline BOOL pico7219_row_blinks (const struct Pico7219 *self, 
+        int row)
+  {
+  return (self->blink_rows >> ((row + self->row_base) & 
+    (PICO7219_ROWS - 1))) & 1;
+  }
+
 /** Change the state of the chip-select line, allowing a very short
     time for it to settle. */
 static void pico7219_cs (const struct Pico7219 *self, uint8_t select)
   {
+  PICO7219_TRACE_INSTANT (PICO7219_TRACE_CS, select);
 #if PICO_ON_DEVICE
   asm volatile("nop \n nop \n nop");
   gpio_put (self->cs, select);  
@@ -64,108 +200,291 @@ static void pico7219_cs (const struct Pico7219 *self, uint8_t select)
 #endif
   }
 
-/** write_word_to_chain() outputs the same 16-bit word as many times
-    as there are modules in the chain. This is mostly used for
-    initialization -- each module will be initialized with the same
-    values, so we must repeat the data output enough times that each
-    module gets a copy. */
-static void pico7219_write_word_to_chain (const struct Pico7219 *self, 
-        uint8_t hi, uint8_t lo)
+/** write_transaction() sends one 16-bit word to each module in the
+    chain, in a single chip-select cycle. buf holds 2 * chain_len 
+    bytes, with the word for the module furthest from the input first.
+    The whole transaction is handed to the SPI peripheral in one call. 
+    The host build prints the words, rather than writing them. */
+static void pico7219_write_transaction (const struct Pico7219 *self, 
+        const uint8_t *buf)
   {
   pico7219_cs (self, 0); 
 #if PICO_ON_DEVICE
-  uint8_t buf[] = {hi, lo};
-  for (int i = 0; i < self->chain_len; i++)
-    spi_write_blocking (self->spi, buf, 2);
+  spi_write_blocking (self->spi, buf, 2 * self->chain_len);
 #else
-  (void)hi; (void)lo;
+  for (int i = 0; i < self->chain_len; i++)
+    printf ("SPI write %02x %02x\n", buf[2 * i], buf[2 * i + 1]);
 #endif
   pico7219_cs (self, 1); 
   }
 
-/* init() sends the same set of initialization values to all modules
-   in the chain. We write zero to all the row buffers, and set
-   reasonable values for the control registers. */
+/** fill_reg_per_module() builds, in buf, a transaction that writes a 
+    register in every module of the chain, with a different value for
+    each module. vals[] is in the same order as the data passed to 
+    set_row_bits(). */
+static void pico7219_fill_reg_per_module (const struct Pico7219 *self, 
+        uint8_t *buf, uint8_t reg, const uint8_t vals[PICO7219_MAX_CHAIN])
+  {
+  int chain_len = self->chain_len;
+  for (int i = 0; i < chain_len; i++)
+    {
+    buf[2 * i] = reg;
+    buf[2 * i + 1] = vals[chain_len - i - 1];
+    }
+  }
+
+/** fill_word_to_chain() builds, in buf, a transaction that writes the 
+    same 16-bit word to every module in the chain. */
+static void pico7219_fill_word_to_chain (const struct Pico7219 *self, 
+        uint8_t *buf, uint8_t hi, uint8_t lo)
+  {
+  // chain_len never exceeds PICO7219_MAX_CHAIN, but the compiler can't
+  //   know that, and warns about overflowing buf if it isn't told
+  for (int i = 0; i < self->chain_len && i < PICO7219_MAX_CHAIN; i++)
+    {
+    buf[2 * i] = hi;
+    buf[2 * i + 1] = lo;
+    }
+  }
+
+/** write_word_to_chain() outputs the same 16-bit word as many times
+    as there are modules in the chain, so each module gets a copy. */
+static void pico7219_write_word_to_chain (const struct Pico7219 *self, 
+        uint8_t hi, uint8_t lo)
+  {
+  uint8_t buf[PICO7219_TRANSACTION_MAX];
+  pico7219_fill_word_to_chain (self, buf, hi, lo);
+  pico7219_write_transaction (self, buf);
+  }
+
+/** write_reg_per_module() writes a register in every module of the 
+    chain in a single transaction, but with a different value for each
+    module. */
+static void pico7219_write_reg_per_module (const struct Pico7219 *self, 
+        uint8_t reg, const uint8_t vals[PICO7219_MAX_CHAIN])
+  {
+  uint8_t buf[PICO7219_TRANSACTION_MAX];
+  pico7219_fill_reg_per_module (self, buf, reg, vals);
+  pico7219_write_transaction (self, buf);
+  }
+
+/** fill_control_reg() builds, in buf, the transaction that restores
+    one of the control registers to its current setting. n is in the 
+    range 0 to PICO7219_REFRESH_CONTROL_STEPS - 1. The last is the 
+    shutdown register, which stays in shutdown while idle mode has put
+    the chain to sleep. */
+static void pico7219_fill_control_reg (const struct Pico7219 *self, 
+        uint8_t *buf, int n)
+  {
+  switch (n)
+    {
+    case 0: 
+      pico7219_fill_word_to_chain (self, buf, PICO7219_TEST_REG, 0x00); 
+      break;
+    case 1: 
+      pico7219_fill_reg_per_module (self, buf, PICO7219_SCAN_LIMIT_REG, 
+        self->scan_limit); 
+      break;
+    case 2: 
+      pico7219_fill_reg_per_module (self, buf, PICO7219_DECODE_REG, 
+        self->decode); 
+      break;
+    case 3: 
+      pico7219_fill_reg_per_module (self, buf, PICO7219_INTENSITY_REG, 
+        self->sent_intensity); 
+      break;
+    default: 
+      pico7219_fill_word_to_chain (self, buf, PICO7219_SHUTDOWN_REG, 
+        self->asleep ? 0x00 : 0x01); 
+      break;
+    }
+  }
+
+/* init() sets reasonable values for the control registers in all
+   modules in the chain, and writes zero to all the row registers. 
+   Each register needs its own chip-select cycle, because that is when
+   the MAX7219 latches its data, but all the transactions are built
+   first, and then sent back-to-back. The display is switched out of
+   shutdown last, so nothing random is shown while we work. */
 static void pico7219_init (const struct Pico7219 *self)
   {
-  // Rows
-  pico7219_write_word_to_chain (self, 0x00, 0x00); 
-  pico7219_write_word_to_chain (self, 0x01, 0x00); 
-  pico7219_write_word_to_chain (self, 0x02, 0x00); 
-  pico7219_write_word_to_chain (self, 0x03, 0x00); 
-  pico7219_write_word_to_chain (self, 0x04, 0x00); 
-  pico7219_write_word_to_chain (self, 0x05, 0x00); 
-  pico7219_write_word_to_chain (self, 0x06, 0x00); 
-  pico7219_write_word_to_chain (self, 0x07, 0x00); 
-  pico7219_write_word_to_chain (self, 0x08, 0x00); 
-  // Control registers
-  pico7219_write_word_to_chain (self, 0x09, 0x00); // Decode mode 
-  pico7219_write_word_to_chain (self, PICO7219_INTENSITY_REG, 0x01); 
-  pico7219_write_word_to_chain (self, 0x0b, 0x07); // scan limit = full 
-  pico7219_write_word_to_chain (self, PICO7219_SHUTDOWN_REG, 0x01); // Run 
-  pico7219_write_word_to_chain (self, 0x0f, 0x00); // Display test = off 
-  }
-
-/** pico7219_create_vdata(). Create enough space for a "virtual"
-    chain of 8x8 displays, whose size is */
-void pico7219_set_virtual_chain_length (struct Pico7219 *self, int chain_len)
-  {
-  if (self->vdata) free (self->vdata);
-  self->vdata = malloc (PICO7219_ROWS * chain_len);
-  memset (self->vdata, 0, PICO7219_ROWS * chain_len);
+  uint8_t burst[PICO7219_REFRESH_STEPS][PICO7219_TRANSACTION_MAX];
+  int n = 0;
+  PICO7219_TRACE_BEGIN (PICO7219_TRACE_INIT, self->chain_len);
+  for (int i = 0; i < PICO7219_REFRESH_CONTROL_STEPS - 1; i++)
+    pico7219_fill_control_reg (self, burst[n++], i);
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    pico7219_fill_word_to_chain (self, burst[n++], row + 1, 0x00);
+  pico7219_fill_control_reg (self, burst[n++], 
+    PICO7219_REFRESH_CONTROL_STEPS - 1);
+
+  for (int i = 0; i < n; i++)
+    pico7219_write_transaction (self, burst[i]);
+  PICO7219_TRACE_END (PICO7219_TRACE_INIT, self->chain_len);
+  }
+
+/** pico7219_set_virtual_chain_length(). Create enough space for a 
+    "virtual" chain of 8x8 displays. If the object was created in static
+    storage, we can only reuse the space we were given. Otherwise, we
+    allocate a new buffer, and only discard the old one if that
+    succeeded. The blink plane is allocated in the same block, 
+    straight after the virtual chain data. */
+BOOL pico7219_set_virtual_chain_length (struct Pico7219 *self, int chain_len)
+  {
+  int size = PICO7219_ROWS * chain_len;
+  if (chain_len <= 0) return FALSE;
+  if (size > self->vdata_capacity)
+    {
+    if (self->is_static) return FALSE;
+    uint8_t *vdata = malloc (2 * size);
+    if (!vdata) return FALSE;
+    if (self->vdata) free (self->vdata);
+    self->vdata = vdata;
+    self->vdata_capacity = size;
+    }
+  self->blink = self->vdata + self->vdata_capacity;
+  memset (self->vdata, 0, size);
+  memset (self->blink, 0, size);
+  self->blink_rows = 0;
   self->vchain_len = chain_len;
+  self->row_base = 0;
+  return TRUE;
   }
 
-/** pico7219_create() */
-struct Pico7219 *pico7219_create (enum PicoSpiNum spi_num, int32_t baud,
-         uint8_t mosi, uint8_t sck, uint8_t cs, uint8_t chain_len, 
-	 BOOL reverse_bits)
+#if PICO_ON_DEVICE
+/** pico7219_spi_setup() initializes an SPI channel and its data and
+    clock pins, and returns the Pico SDK's SPI device. */
+static spi_inst_t *pico7219_spi_setup (enum PicoSpiNum spi_num, 
+         int32_t baud, uint8_t mosi, uint8_t sck)
+  {
+  spi_inst_t *spi = spi_num == PICO_SPI_1 ? spi1 : spi0;
+  spi_init (spi, baud); 
+  gpio_set_function(mosi, GPIO_FUNC_SPI);
+  gpio_set_function(sck, GPIO_FUNC_SPI);
+  return spi;
+  }
+#endif
+
+/** pico7219_setup() initializes an object whose memory has already
+    been obtained, either from the heap or from the caller, and then
+    initializes the hardware. The vdata buffer must already be in place. 
+    If bus is not NULL, the SPI channel has already been initialized
+    by the bus, and only the chip-select pin is set up here. */
+static void pico7219_setup (struct Pico7219 *self, enum PicoSpiNum spi_num, 
+         int32_t baud, uint8_t mosi, uint8_t sck, uint8_t cs, 
+         uint8_t chain_len, BOOL reverse_bits, struct Pico7219Bus *bus)
+  {
+  self->bus = bus;
+  self->priority = 0;
+  self->chain_len = chain_len;
+  self->cs = cs;
+  self->spi_num = spi_num;
+  self->reverse_bits = reverse_bits;
+  // Set data buffer to all "off", as that's how the LEDs power up
+  memset (self->data, 0, sizeof (self->data));
+  // Set all data clean
+  memset (self->row_dirty, 0, sizeof (self->row_dirty));
+  // All modules start as LED matrices; these are the values that 
+  //   init() writes
+  memset (self->module_mode, PICO7219_MODE_MATRIX, 
+    sizeof (self->module_mode));
+  memset (self->decode, 0x00, sizeof (self->decode));
+  memset (self->scan_limit, 0x07, sizeof (self->scan_limit));
+  self->intensity = 0x01;
+  self->intensity_pending = FALSE;
+  memset (self->sent_intensity, self->intensity, 
+    sizeof (self->sent_intensity));
+  self->current_budget = 0;
+  self->budget_per_module = FALSE;
+  self->isr_head = 0;
+  self->isr_tail = 0;
+  self->refresh = FALSE;
+  self->refresh_step = 0;
+  self->blink_period = 0;
+  self->blink_off = FALSE;
+  self->idle = FALSE;
+  self->asleep = FALSE;
+  self->frame_hash_valid = FALSE;
+  self->zone_count = 0;
+#if PICO_ON_DEVICE
+  // Initialize the SPI and GPIO 
+  if (bus)
+    self->spi = bus->spi;
+  else
+    self->spi = pico7219_spi_setup (spi_num, baud, mosi, sck);
+
+  gpio_init (self->cs);
+  gpio_set_dir (self->cs, GPIO_OUT);
+  gpio_put (self->cs, 1);
+#else
+  if (bus)
+    printf ("Init display on shared SPI %d, cs=%d\n", self->spi_num, self->cs);
+  else
+    printf ("Init SPI %d at %d baud, mosi=%d, sck=%d, cs=%d\n", 
+     self->spi_num, baud, mosi, sck, self->cs);
+#endif
+
+  // Initialize the hardware
+  pico7219_init (self);
+  }
+
+/** pico7219_alloc() allocates an object and its virtual chain buffer
+    from the heap. Returns NULL if there isn't enough memory. */
+static struct Pico7219 *pico7219_alloc (void)
   {
   struct Pico7219 *self = malloc (sizeof (struct Pico7219));  
   if (self)
     {
-    self->chain_len = chain_len;
-    self->cs = cs;
-    self->spi_num = spi_num;
-    self->reverse_bits = reverse_bits;
+    self->is_static = FALSE;
     self->vdata = NULL;
+    self->vdata_capacity = 0;
     self->vchain_len = 0;
     // Start with the virtual chain length the same as the maximum 
     //  physical chain length
-    pico7219_set_virtual_chain_length (self, PICO7219_MAX_CHAIN);
-    // Set data buffer to all "off", as that's how the LEDs power up
-    memset (self->data, 0, sizeof (self->data));
-    // Set all data clean
-    memset (self->row_dirty, 0, sizeof (self->row_dirty));
-#if PICO_ON_DEVICE
-    switch (spi_num)
+    if (!pico7219_set_virtual_chain_length (self, PICO7219_MAX_CHAIN))
       {
-      case PICO_SPI_0:
-        self->spi = spi0;
-	break;
-      case PICO_SPI_1:
-        self->spi = spi1;
-	break;
+      free (self);
+      return NULL;
       }
+    }
+  return self;
+  }
 
-    // Initialize the SPI and GPIO 
-    
-    spi_init (self->spi, baud); 
-
-    gpio_set_function(mosi, GPIO_FUNC_SPI);
-    gpio_set_function(sck, GPIO_FUNC_SPI);
+/** pico7219_create() */
+struct Pico7219 *pico7219_create (enum PicoSpiNum spi_num, int32_t baud,
+         uint8_t mosi, uint8_t sck, uint8_t cs, uint8_t chain_len, 
+	 BOOL reverse_bits)
+  {
+  if (chain_len > PICO7219_MAX_CHAIN) return NULL;
+  struct Pico7219 *self = pico7219_alloc ();
+  if (self)
+    pico7219_setup (self, spi_num, baud, mosi, sck, cs, chain_len, 
+      reverse_bits, NULL);
+  return self;
+  }
 
-    gpio_init (self->cs);
-    gpio_set_dir (self->cs, GPIO_OUT);
-    gpio_put (self->cs, 1);
-#else
-printf ("Init SPI %d at %d baud, mosi=%d, sck=%d, cs=%d\n", 
-     self->spi_num, baud, mosi, sck, self->cs);
-#endif
+/** pico7219_init_static() */
+struct Pico7219 *pico7219_init_static (void *storage, size_t storage_size,
+         enum PicoSpiNum spi_num, int32_t baud, uint8_t mosi, uint8_t sck, 
+         uint8_t cs, uint8_t chain_len, int vchain_len, BOOL reverse_bits)
+  {
+  if (!storage || chain_len > PICO7219_MAX_CHAIN || vchain_len <= 0) 
+    return NULL;
+  if ((uintptr_t)storage % sizeof (uint64_t) != 0) return NULL;
+  if (storage_size < (size_t)PICO7219_STATIC_SIZE (chain_len, vchain_len))
+    return NULL;
 
-    // Initialize the hardware
-    pico7219_init (self);
-    }
+  // The object goes at the start of the storage, and the virtual chain
+  //   buffer follows it. The virtual chain buffer is never smaller
+  //   than the physical chain, so the chain can always be filled.
+  struct Pico7219 *self = storage;
+  self->is_static = TRUE;
+  self->vdata = (uint8_t *)storage + PICO7219_OBJECT_SIZE;
+  self->vdata_capacity = (storage_size - PICO7219_OBJECT_SIZE) / 2;
+  self->vchain_len = 0;
+  pico7219_set_virtual_chain_length (self, vchain_len);
+  pico7219_setup (self, spi_num, baud, mosi, sck, cs, chain_len, 
+    reverse_bits, NULL);
   return self;
   }
 
@@ -174,15 +493,30 @@ void pico7219_destroy (struct Pico7219 *self, BOOL deinit)
   {
   if (self)
     {
-    if (self->vdata) free (self->vdata);
     pico7219_write_word_to_chain (self, PICO7219_SHUTDOWN_REG, 0x00); // off 
-    if (deinit)
+    if (self->bus)
+      {
+      // The SPI channel belongs to the bus, so is never deinitialized
+      //   here; just take the display off the bus's list
+      struct Pico7219Bus *bus = self->bus;
+      int i = 0;
+      while (bus->displays[i] != self) i++;
+      if (i < bus->next) bus->next--;
+      bus->count--;
+      for (; i < bus->count; i++) bus->displays[i] = bus->displays[i + 1];
+      if (bus->next >= bus->count) bus->next = 0;
+      }
+    else if (deinit)
       {
 #if PICO_ON_DEVICE
       spi_deinit (self->spi);
 #endif
       }
-    free (self);
+    if (!self->is_static)
+      {
+      if (self->vdata) free (self->vdata);
+      free (self);
+      }
     }
   }
 
@@ -199,29 +533,27 @@ static uint8_t pico7219_reverse_bits (uint8_t b)
 void pico7219_set_row_bits (const struct Pico7219 *self, uint8_t row, 
         const uint8_t bits[PICO7219_MAX_CHAIN]) 
   {
-  pico7219_cs (self, 0); 
+  uint8_t buf[PICO7219_TRANSACTION_MAX];
   int chain_len = self->chain_len;
+  PICO7219_TRACE_BEGIN (PICO7219_TRACE_ROW, row);
   for (int i = 0; i < chain_len; i++)
     {
-    uint8_t v = bits[chain_len - i - 1];
-    if (self->reverse_bits)
+    int module = chain_len - i - 1;
+    uint8_t v = bits[module];
+    if (self->reverse_bits && self->module_mode[module] == PICO7219_MODE_MATRIX)
       v = pico7219_reverse_bits (v);
-    uint8_t buf[] = {row + 1, v};
-#if PICO_ON_DEVICE
-    spi_write_blocking (self->spi, buf, 2);
-#else
-    printf ("SPI write %02x %02x\n", buf[0], buf[1]);
-#endif
+    buf[2 * i] = row + 1;
+    buf[2 * i + 1] = v;
     }
-  pico7219_cs (self, 1); 
+  pico7219_write_transaction (self, buf);
+  PICO7219_TRACE_END (PICO7219_TRACE_ROW, row);
   }
 
 /** pico7219_switch_off_row() */
 void pico7219_switch_off_row (struct Pico7219 *self, uint8_t row, BOOL flush)
   {
   self->row_dirty[row] = TRUE;
-  //fprintf (stderr, "row = %d len=%d\n", row, self->vchain_len);
-  memset (self->vdata + row * self->vchain_len, 0x0, self->vchain_len);
+  memset (pico7219_vrow (self, row), 0x0, self->vchain_len);
   if (flush) pico7219_flush (self);
   }
 
@@ -237,7 +569,7 @@ void pico7219_switch_off_all (struct Pico7219 *self, BOOL flush)
 void pico7219_switch_on_row (struct Pico7219 *self, uint8_t row, BOOL flush)
   {
   self->row_dirty[row] = TRUE;
-  memset (self->vdata + row * self->vchain_len, 0xFF, self->vchain_len);
+  memset (pico7219_vrow (self, row), 0xFF, self->vchain_len);
   if (flush) pico7219_flush (self);
   }
 
@@ -249,111 +581,1329 @@ void pico7219_switch_on_all (struct Pico7219 *self, BOOL flush)
   if (flush) pico7219_flush (self);
   }
 
+/** put_pixel() turns one LED of the virtual chain on or off, and marks
+    its row dirty. The column is an int, so that it can address the 
+    whole of a virtual chain more than 256 pixels long. Returns FALSE, 
+    having done nothing, if the position is outside the virtual chain. */
+static BOOL pico7219_put_pixel (struct Pico7219 *self, int row, int col, 
+        BOOL on)
+  {
+  if (row < 0 || row >= PICO7219_ROWS || col < 0 || 
+      col >= PICO7219_COLS * self->vchain_len)
+    return FALSE;
+  uint8_t v = 1 << (col & 7);
+  uint8_t *b = pico7219_vrow (self, row) + (col >> 3);
+  if (on)
+    *b |= v;
+  else
+    *b &= ~v;
+  self->row_dirty[row] = TRUE;
+  return TRUE;
+  }
+
 /** pico7219_switch_on() */
 void pico7219_switch_on (struct Pico7219 *self, uint8_t row, 
        uint8_t col, BOOL flush)
   {
-  if (row < PICO7219_ROWS && col < PICO7219_COLS * self->vchain_len)
-    {
-    int block = col / 8;
-    int pos = col - 8 * block;
-    uint8_t v = 1 << pos;
-    self->vdata[row * self->vchain_len + block] |= v;
-    self->row_dirty[row] = TRUE;
-    if (flush) pico7219_flush (self);
-    } 
+  if (pico7219_put_pixel (self, row, col, TRUE) && flush) 
+    pico7219_flush (self);
   }
 
 /** pico7219_switch_off() */
 void pico7219_switch_off (struct Pico7219 *self, uint8_t row, 
        uint8_t col, BOOL flush)
   {
-  if (row < PICO7219_ROWS && col < PICO7219_COLS * self->vchain_len)
-    {
-    int block = col / 8;
-    int pos = col - 8 * block;
-    uint8_t v = 1 << pos;
-    self->vdata[row * self->vchain_len + block] &= ~v;
-    self->row_dirty[row] = TRUE;
-    if (flush) pico7219_flush (self);
-    }
+  if (pico7219_put_pixel (self, row, col, FALSE) && flush) 
+    pico7219_flush (self);
   }
 
-/** Copy from the virtual chain to self->data, preparatory to 
-    writing to the device. This function will only write the start
-    of the virtual chain, if it is longer than the physical chain. */
-static void pico7219_vrow_to_row (struct Pico7219 *self, int row)
+/** pico7219_set_pixel() */
+void pico7219_set_pixel (struct Pico7219 *self, int row, int col, BOOL on,
+       BOOL flush)
   {
-  int target_mods = self->chain_len;
-  if (target_mods > self->vchain_len) target_mods = self->vchain_len;
-  int row_start = row * self->vchain_len;
-  for (int i = 0; i < target_mods; i++)
+  if (pico7219_put_pixel (self, row, col, on) && flush) 
+    pico7219_flush (self);
+  }
+
+/** pico7219_set_pixels() */
+void pico7219_set_pixels (struct Pico7219 *self, 
+       const struct Pico7219Point *pts, int n, BOOL on, BOOL flush)
+  {
+  int width = PICO7219_COLS * self->vchain_len;
+  // One pass to find the extent of the points, so that the range 
+  //   check is done once for the whole set
+  unsigned max_col = 0, max_row = 0;
+  for (int i = 0; i < n; i++)
+    {
+    max_col = pts[i].col > max_col ? pts[i].col : max_col;
+    max_row = pts[i].row > max_row ? pts[i].row : max_row;
+    }
+  BOOL valid = max_col < (unsigned)width && max_row < PICO7219_ROWS;
+
+  uint8_t *rows[PICO7219_ROWS];
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    rows[row] = pico7219_vrow (self, row);
+
+  uint8_t dirty = 0;
+  if (valid && on)
+    {
+    for (int i = 0; i < n; i++)
+      {
+      rows[pts[i].row][pts[i].col >> 3] |= 1 << (pts[i].col & 7);
+      dirty |= 1 << pts[i].row;
+      }
+    }
+  else if (valid)
+    {
+    for (int i = 0; i < n; i++)
+      {
+      rows[pts[i].row][pts[i].col >> 3] &= ~(1 << (pts[i].col & 7));
+      dirty |= 1 << pts[i].row;
+      }
+    }
+  else
+    {
+    for (int i = 0; i < n; i++)
+      {
+      int row = pts[i].row, col = pts[i].col;
+      if (row >= PICO7219_ROWS || col >= width) continue;
+      if (on)
+        rows[row][col >> 3] |= 1 << (col & 7);
+      else
+        rows[row][col >> 3] &= ~(1 << (col & 7));
+      dirty |= 1 << row;
+      }
+    }
+
+  for (int row = 0; row < PICO7219_ROWS; row++)
     {
-    self->data[row][i] = self->vdata[row_start + i];
+    if (dirty & (1 << row)) self->row_dirty[row] = TRUE;
     }
+  if (flush) pico7219_flush (self);
   }
 
-/** Scroll one pixel left. */
-void pico7219_scroll (struct Pico7219 *self, BOOL wrap)
+/** pico7219_set_column() */
+void pico7219_set_column (struct Pico7219 *self, int col, uint8_t bits, 
+       BOOL flush)
   {
-  int target_mods = self->chain_len;
-  if (target_mods > self->vchain_len) target_mods = self->vchain_len;
-
-  // Shift bits in vdata
-  // This logic is twisted because the bits are in MSB-LSB order in the 
-  //   opposite order from the modules. So when we shift a bit rightwards
-  //   off the end of one module, it appears as the MSB in the next, not
-  //   the LSB.
+  if (col < 0 || col >= PICO7219_COLS * self->vchain_len) return;
+  int block = col / 8;
+  uint8_t v = 1 << (col % 8);
   for (int row = 0; row < PICO7219_ROWS; row++)
     {
-    int row_start = row * self->vchain_len;
-    uint8_t carry = 0;
-    int l = self->vchain_len - 1;
-    for (int i = l; i >= 0; i--)
+    uint8_t *b = pico7219_vrow (self, row) + block;
+    uint8_t nv = (bits & (1 << row)) ? (*b | v) : (*b & ~v);
+    if (nv != *b)
       {
-      int row_offset = row_start + i;
-      BOOL carry_next = FALSE;
+      *b = nv;
+      self->row_dirty[row] = TRUE;
+      }
+    }
+  if (flush) pico7219_flush (self);
+  }
 
-      if (self->vdata[row_offset] & 0x01) carry_next = TRUE;
-      self->vdata[row_offset] >>= 1; 
+/** pico7219_fill_rect() */
+void pico7219_fill_rect (struct Pico7219 *self, int x, int y, int w, 
+       int h, BOOL on, BOOL flush)
+  {
+  int width = PICO7219_COLS * self->vchain_len;
+  int x1 = x + w, y1 = y + h;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > width) x1 = width;
+  if (y1 > PICO7219_ROWS) y1 = PICO7219_ROWS;
+  if (x >= x1 || y >= y1) return;
+
+  // Work out the partial bytes at each end of the span, and the whole
+  //   bytes between them, once for all the rows
+  int first = x / 8, last = (x1 - 1) / 8;
+  uint8_t first_mask = 0xFF << (x % 8);
+  uint8_t last_mask = 0xFF >> (7 - (x1 - 1) % 8);
+  if (first == last) first_mask &= last_mask;
 
-      // If we're at position 0, and the shift would carry, we have to
-      //   carry to position "-1" which, of course, does not exist. So,
-      //   instead, we carry to position l, that is, to the far end of
-      //   the chain.
-      if (wrap)
+  for (int row = y; row < y1; row++)
+    {
+    uint8_t *r = pico7219_vrow (self, row);
+    if (on)
+      {
+      r[first] |= first_mask;
+      if (last > first) 
         {
-        if (i == 0 && carry_next)
-          self->vdata[row_start + l] |= 0x80;
+        memset (r + first + 1, 0xFF, last - first - 1);
+        r[last] |= last_mask;
         }
+      }
+    else
+      {
+      r[first] &= ~first_mask;
+      if (last > first)
+        {
+        memset (r + first + 1, 0x00, last - first - 1);
+        r[last] &= ~last_mask;
+        }
+      }
+    self->row_dirty[row] = TRUE;
+    }
+  if (flush) pico7219_flush (self);
+  }
 
-      self->vdata[row_offset] |= carry; 
-      carry = 0;
+// bar_rows[h] has the bit at position 8 * row set for each row below
+//   height h. Shifting it left by a column number, and ORing the results
+//   for eight columns, gives all eight rows of one module at once. 
+static const uint64_t pico7219_bar_rows[PICO7219_ROWS + 1] =
+  {
+  0x0000000000000000ULL, 0x0000000000000001ULL, 0x0000000000000101ULL,
+  0x0000000000010101ULL, 0x0000000001010101ULL, 0x0000000101010101ULL,
+  0x0000010101010101ULL, 0x0001010101010101ULL, 0x0101010101010101ULL
+  };
 
-      if (carry_next)
-	carry = 0x80;
-      }
+/** pico7219_draw_bars() */
+void pico7219_draw_bars (struct Pico7219 *self, int x, 
+       const uint8_t *heights, int n, int bar_width, int gap, BOOL flush)
+  {
+  int width = PICO7219_COLS * self->vchain_len;
+  int pitch = bar_width + gap;
+  if (n <= 0 || bar_width <= 0 || gap < 0) return;
+  int start = x < 0 ? 0 : x;
+  int end = x + n * pitch; // One past the last column of the bar area
+  if (end > width) end = width;
+  if (start >= end) return;
+
+  // Track which bar, and how far into it, the current column is, 
+  //  so that we don't need to divide for each column.
+  int bar = (start - x) / pitch;
+  int within = (start - x) % pitch;
 
-    pico7219_set_row_bits (self, row, self->vdata + row * self->vchain_len);
+  for (int block = start / 8; block <= (end - 1) / 8; block++)
+    {
+    uint64_t rows = 0; 
+    uint8_t mask = 0;
+    int first = block * 8 < start ? start - block * 8 : 0; 
+    int last = block * 8 + 8 > end ? end - block * 8 : 8; 
+    for (int j = first; j < last; j++)
+      {
+      if (within < bar_width)
+        {
+        uint8_t h = heights[bar];
+        if (h > PICO7219_ROWS) h = PICO7219_ROWS;
+        rows |= pico7219_bar_rows[h] << j;
+        }
+      mask |= 1 << j;
+      if (++within == pitch)
+        {
+        within = 0;
+        bar++;
+        }
+      }
+    for (int row = 0; row < PICO7219_ROWS; row++)
+      {
+      uint8_t *b = pico7219_vrow (self, row) + block;
+      uint8_t nv = (*b & ~mask) | (uint8_t)(rows >> (8 * row));
+      if (nv != *b)
+        {
+        *b = nv;
+        self->row_dirty[row] = TRUE;
+        }
+      }
     }
+  if (flush) pico7219_flush (self);
   }
 
-/** pico7219_flush() */
-void pico7219_flush (struct Pico7219 *self)
+/** pico7219_set_row() */
+void pico7219_set_row (struct Pico7219 *self, uint8_t row, 
+       const uint8_t *bits, BOOL flush)
   {
-  for (int i = 0; i < PICO7219_ROWS; i++)
+  if (row >= PICO7219_ROWS) return;
+  uint8_t *r = pico7219_vrow (self, row);
+  if (memcmp (r, bits, self->vchain_len) != 0)
     {
-    pico7219_vrow_to_row (self, i);
-    if (self->row_dirty[i])
-      pico7219_set_row_bits (self, i, self->data[i]);
-    self->row_dirty[i] = FALSE;
+    memcpy (r, bits, self->vchain_len);
+    self->row_dirty[row] = TRUE;
     }
+  if (flush) pico7219_flush (self);
   }
 
-/** pico7219_set_intensity() */
-void pico7219_set_intensity (struct Pico7219 *self, uint8_t intensity)
+/** pico7219_get_row_buffer() */
+uint8_t *pico7219_get_row_buffer (struct Pico7219 *self, uint8_t row)
+  {
+  return pico7219_vrow (self, row & (PICO7219_ROWS - 1));
+  }
+
+/** pico7219_get_blink_row_buffer() */
+uint8_t *pico7219_get_blink_row_buffer (struct Pico7219 *self, 
+      uint8_t row)
+  {
+  row &= PICO7219_ROWS - 1;
+  if (!pico7219_row_blinks (self, row)) return NULL;
+  return pico7219_brow (self, row);
+  }
+
+/** pico7219_mark_row_dirty() */
+void pico7219_mark_row_dirty (struct Pico7219 *self, uint8_t row)
+  {
+  if (row < PICO7219_ROWS) self->row_dirty[row] = TRUE;
+  }
+
+/** pico7219_get_display_row() */
+void pico7219_get_display_row (const struct Pico7219 *self, uint8_t row, 
+       uint8_t bits[PICO7219_MAX_CHAIN])
+  {
+  if (row < PICO7219_ROWS)
+    memcpy (bits, self->data[row], PICO7219_MAX_CHAIN);
+  }
+
+/** pico7219_get_chain_length() */
+uint8_t pico7219_get_chain_length (const struct Pico7219 *self)
+  {
+  return self->chain_len;
+  }
+
+/** pico7219_get_virtual_chain_length() */
+int pico7219_get_virtual_chain_length (const struct Pico7219 *self)
+  {
+  return self->vchain_len;
+  }
+
+/** pico7219_time_us() */
+uint64_t pico7219_time_us (void)
+  {
+#if PICO_ON_DEVICE
+  return time_us_64 ();
+#else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+  }
+
+/** Get the eight pixels of a virtual chain row starting at column col,
+    in bits 0-7. Columns past the end of the chain are dark. */
+static inline uint8_t pico7219_get_bits8 (const struct Pico7219 *self, 
+        const uint8_t *vrow, int col)
+  {
+  int b = col >> 3;
+  int shift = col & 7;
+  if (b >= self->vchain_len) return 0;
+  uint16_t v = vrow[b];
+  if (shift && b + 1 < self->vchain_len) v |= vrow[b + 1] << 8;
+  return v >> shift;
+  }
+
+/** Set n pixels (1-8) of a display row, starting at column col, to
+    bits 0 to n - 1 of v. */
+static inline void pico7219_put_bits (uint8_t *out, int col, uint8_t v, 
+        int n)
   {
-  pico7219_write_word_to_chain (self, PICO7219_INTENSITY_REG, intensity); 
+  int b = col >> 3;
+  int shift = col & 7;
+  uint16_t mask = ((1u << n) - 1) << shift;
+  uint16_t bits = (v << shift) & mask;
+  out[b] = (out[b] & ~mask) | bits;
+  if (mask >> 8) out[b + 1] = (out[b + 1] & ~(mask >> 8)) | (bits >> 8);
   }
 
+/** Copy the part of one row of the virtual chain that each zone shows
+    into the zone's columns of out, which is a row of self->data, or
+    laid out the same way. A zone's viewport is copied in runs that 
+    end where the source ends or wraps. */
+static void pico7219_zones_to_row (const struct Pico7219 *self, 
+        const uint8_t *vrow, uint8_t *out)
+  {
+  for (int z = 0; z < self->zone_count; z++)
+    {
+    const struct Pico7219Zone *zone = &self->zones[z];
+    int src_width = zone->src_width;
+    int x = 0;
+    while (x < zone->width)
+      {
+      int s = zone->offset + x;
+      int n = zone->width - x;
+      BOOL blank = FALSE;
+      if (zone->wrap)
+        {
+        s %= src_width;
+        if (s < 0) s += src_width;
+        }
+      if (s < 0)
+        {
+        blank = TRUE;
+        if (n > -s) n = -s;
+        }
+      else if (s >= src_width)
+        blank = TRUE;
+      else if (n > src_width - s)
+        n = src_width - s;
+      for (int i = 0; i < n; i += 8)
+        {
+        int k = n - i < 8 ? n - i : 8;
+        uint8_t v = blank ? 0 : 
+          pico7219_get_bits8 (self, vrow, zone->src_col + s + i);
+        pico7219_put_bits (out, zone->first_col + x + i, v, k);
+        }
+      x += n;
+      }
+    }
+  }
 
+/** Copy from the virtual chain to self->data, preparatory to 
+    writing to the device. This function will only write the start
+    of the virtual chain, if it is longer than the physical chain. */
+static void pico7219_vrow_to_row (struct Pico7219 *self, int row)
+  {
+  int target_mods = self->chain_len;
+  if (target_mods > self->vchain_len) target_mods = self->vchain_len;
+  const uint8_t *vrow = pico7219_vrow (self, row);
+  BOOL masked = self->blink_off && pico7219_row_blinks (self, row);
+  if (masked)
+    {
+    // Mask out the blinking pixels, eight modules at a time
+    const uint8_t *brow = pico7219_brow (self, row);
+    for (int i = 0; i < target_mods; i += 8)
+      {
+      int n = target_mods - i < 8 ? target_mods - i : 8;
+      uint64_t v = 0, b = 0;
+      memcpy (&v, vrow + i, n);
+      memcpy (&b, brow + i, n);
+      v &= ~b;
+      memcpy (self->data[row] + i, &v, n);
+      }
+    }
+  else
+    {
+    for (int i = 0; i < target_mods; i++)
+      {
+      self->data[row][i] = vrow[i];
+      }
+    }
+  if (self->zone_count)
+    {
+    pico7219_zones_to_row (self, vrow, self->data[row]);
+    if (masked)
+      {
+      // The blink plane goes through the zones in the same way
+      uint8_t b[PICO7219_MAX_CHAIN] = {0};
+      pico7219_zones_to_row (self, pico7219_brow (self, row), b);
+      for (int i = 0; i < self->chain_len; i++)
+        self->data[row][i] &= ~b[i];
+      }
+    }
+  }
+
+/** Reverse the order of len bytes in place. */
+static void pico7219_reverse_bytes (uint8_t *b, int len)
+  {
+  for (int i = 0, j = len - 1; i < j; i++, j--)
+    {
+    uint8_t t = b[i];
+    b[i] = b[j];
+    b[j] = t;
+    }
+  }
+
+/** Shift one row of the virtual chain n pixels to the left, that is, 
+    towards column 0. n must be in the range 0 to one less than the
+    number of pixels in the row. With wrap, pixels shifted off column 0 
+    reappear at the far end of the row; otherwise the far end fills 
+    with zeros.
+    This logic is twisted because the bits are in MSB-LSB order in the 
+    opposite order from the modules. So when we shift a bit rightwards
+    off the end of one module, it appears as the MSB in the next, not
+    the LSB. */
+static void pico7219_shift_row_left (uint8_t *r, int len, int n, BOOL wrap)
+  {
+  int k = n / 8; // Whole bytes
+  int b = n % 8; // Remaining bits
+  if (wrap)
+    {
+    // Rotate whole bytes by k using three reversals, which needs no
+    //   temporary storage, then rotate the remaining bits, carrying
+    //   from byte 0 into the last byte.
+    if (k)
+      {
+      pico7219_reverse_bytes (r, k);
+      pico7219_reverse_bytes (r + k, len - k);
+      pico7219_reverse_bytes (r, len);
+      }
+    if (b)
+      {
+      uint8_t first = r[0];
+      for (int i = 0; i < len; i++)
+        {
+        uint8_t next = (i + 1 < len) ? r[i + 1] : first;
+        r[i] = (r[i] >> b) | (uint8_t)(next << (8 - b));
+        }
+      }
+    }
+  else
+    {
+    // Each byte depends only on bytes at or above its own position, so
+    //   we can work upwards in place.
+    for (int i = 0; i < len; i++)
+      {
+      uint8_t lo = (i + k < len) ? r[i + k] : 0;
+      uint8_t hi = (i + k + 1 < len) ? r[i + k + 1] : 0;
+      r[i] = b ? (lo >> b) | (uint8_t)(hi << (8 - b)) : lo;
+      }
+    }
+  }
+
+/** Shift one row of the virtual chain n pixels to the right. Without
+    wrap, this is the mirror image of shift_row_left(), working 
+    downwards; with wrap, it is the same as shifting the other way. */
+static void pico7219_shift_row_right (uint8_t *r, int len, int n, BOOL wrap)
+  {
+  if (wrap)
+    {
+    pico7219_shift_row_left (r, len, (8 * len - n) % (8 * len), TRUE);
+    return;
+    }
+  int k = n / 8;
+  int b = n % 8;
+  for (int i = len - 1; i >= 0; i--)
+    {
+    uint8_t hi = (i - k >= 0) ? r[i - k] : 0;
+    uint8_t lo = (i - k - 1 >= 0) ? r[i - k - 1] : 0;
+    r[i] = b ? (uint8_t)(hi << b) | (lo >> (8 - b)) : hi;
+    }
+  }
+
+/** Move the display rows by dy, positive being upwards, by changing
+    row_base. Without wrap, the rows that come into view are cleared. */
+static void pico7219_shift_rows (struct Pico7219 *self, int dy, BOOL wrap)
+  {
+  int n = dy % PICO7219_ROWS;
+  if (n < 0) n += PICO7219_ROWS;
+  self->row_base = (self->row_base - n) & (PICO7219_ROWS - 1);
+  if (!wrap)
+    {
+    int clear = dy < 0 ? -dy : dy;
+    if (clear > PICO7219_ROWS) clear = PICO7219_ROWS;
+    for (int i = 0; i < clear; i++)
+      {
+      int row = dy > 0 ? i : PICO7219_ROWS - 1 - i;
+      memset (pico7219_vrow (self, row), 0, self->vchain_len);
+      memset (pico7219_brow (self, row), 0, self->vchain_len);
+      }
+    }
+  }
+
+/** Mark every row dirty, so the next flush sends the whole display. */
+static void pico7219_mark_all_dirty (struct Pico7219 *self)
+  {
+  memset (self->row_dirty, TRUE, sizeof (self->row_dirty));
+  }
+
+/** Scroll one pixel left. */
+void pico7219_scroll (struct Pico7219 *self, BOOL wrap)
+  {
+  pico7219_scroll_by (self, 1, 0, wrap);
+  }
+
+/** pico7219_scroll_up() */
+void pico7219_scroll_up (struct Pico7219 *self, BOOL wrap)
+  {
+  pico7219_scroll_by (self, 0, 1, wrap);
+  }
+
+/** pico7219_scroll_down() */
+void pico7219_scroll_down (struct Pico7219 *self, BOOL wrap)
+  {
+  pico7219_scroll_by (self, 0, -1, wrap);
+  }
+
+/** pico7219_scroll_by() */
+void pico7219_scroll_by (struct Pico7219 *self, int dx, int dy, BOOL wrap)
+  {
+  PICO7219_TRACE_BEGIN (PICO7219_TRACE_SCROLL, dx);
+  pico7219_move (self, dx, dy, wrap);
+  pico7219_flush (self);
+  PICO7219_TRACE_END (PICO7219_TRACE_SCROLL, dx);
+  }
+
+/** pico7219_move() */
+void pico7219_move (struct Pico7219 *self, int dx, int dy, BOOL wrap)
+  {
+  int width = PICO7219_COLS * self->vchain_len;
+  if (dx != 0)
+    {
+    int n = dx < 0 ? -dx : dx;
+    if (wrap) 
+      n %= width;
+    for (int row = 0; row < PICO7219_ROWS; row++)
+      {
+      uint8_t *r = pico7219_vrow (self, row);
+      if (n >= width)
+        memset (r, 0, self->vchain_len);
+      else if (dx > 0)
+        pico7219_shift_row_left (r, self->vchain_len, n, wrap);
+      else
+        pico7219_shift_row_right (r, self->vchain_len, n, wrap);
+      // Blinking pixels move with the image
+      if (!pico7219_row_blinks (self, row)) continue;
+      r = pico7219_brow (self, row);
+      if (n >= width)
+        memset (r, 0, self->vchain_len);
+      else if (dx > 0)
+        pico7219_shift_row_left (r, self->vchain_len, n, wrap);
+      else
+        pico7219_shift_row_right (r, self->vchain_len, n, wrap);
+      }
+    }
+  if (dy != 0)
+    pico7219_shift_rows (self, dy, wrap);
+  pico7219_mark_all_dirty (self);
+  }
+
+/** Count the LEDs that are lit in each module in self->data. This
+    runs on every flush when the current limit is in use, so it works
+    on eight modules at a time: each row of eight bytes is loaded into
+    a 64-bit word, and the bits in each byte are counted in parallel,
+    leaving a count in each byte of the word. A byte can't overflow,
+    because there are only 64 LEDs in a module. Digit modules are not 
+    counted, because their LEDs depend on the decoder. */
+static void pico7219_count_lit (const struct Pico7219 *self, 
+        uint8_t lit[PICO7219_MAX_CHAIN])
+  {
+  for (int c = 0; c < self->chain_len; c += 8)
+    {
+    int n = self->chain_len - c < 8 ? self->chain_len - c : 8;
+    uint64_t acc = 0;
+    for (int row = 0; row < PICO7219_ROWS; row++)
+      {
+      uint64_t x = 0;
+      memcpy (&x, self->data[row] + c, n);
+      x = x - ((x >> 1) & 0x5555555555555555ULL);
+      x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+      x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+      acc += x;
+      }
+    memcpy (lit + c, &acc, n);
+    }
+  for (int i = 0; i < self->chain_len; i++)
+    if (self->module_mode[i] != PICO7219_MODE_MATRIX) lit[i] = 0;
+  }
+
+/** Work out the highest intensity at which "lit" LEDs stay within
+    the current budget, but no higher than the intensity that was
+    set. At intensity n the MAX7219 drives the LEDs for (2n + 1)/32
+    of the time, so the current is proportional to lit * (2n + 1), and
+    the budget is a number of LEDs at full intensity (n = 15). */
+static uint8_t pico7219_limit_intensity (const struct Pico7219 *self, 
+        uint32_t lit)
+  {
+  if (lit == 0) return self->intensity;
+  uint32_t k = (uint32_t)self->current_budget * 31 / lit;
+  uint32_t n = k > 0 ? (k - 1) / 2 : 0;
+  return n < self->intensity ? n : self->intensity;
+  }
+
+/** Work out the intensity each module should have for the data in 
+    self->data, then write it. Reductions are written before the new 
+    rows are sent, and increases after, so that we never exceed the
+    budget during the change. The "before" argument says which of 
+    those we're doing now. */
+static void pico7219_apply_intensity (struct Pico7219 *self, BOOL before)
+  {
+  uint8_t target[PICO7219_MAX_CHAIN];
+  if (self->current_budget)
+    {
+    uint8_t lit[PICO7219_MAX_CHAIN];
+    pico7219_count_lit (self, lit);
+    if (self->budget_per_module)
+      {
+      for (int i = 0; i < self->chain_len; i++)
+        target[i] = pico7219_limit_intensity (self, lit[i]);
+      }
+    else
+      {
+      uint32_t total = 0;
+      for (int i = 0; i < self->chain_len; i++) total += lit[i];
+      memset (target, pico7219_limit_intensity (self, total), 
+        sizeof (target));
+      }
+    }
+  else
+    memset (target, self->intensity, sizeof (target));
+
+  BOOL changed = FALSE;
+  for (int i = 0; i < self->chain_len; i++)
+    {
+    if (before ? target[i] < self->sent_intensity[i] 
+               : target[i] != self->sent_intensity[i])
+      {
+      self->sent_intensity[i] = target[i];
+      changed = TRUE;
+      }
+    }
+  if (changed)
+    pico7219_write_reg_per_module (self, PICO7219_INTENSITY_REG, 
+      self->sent_intensity);
+  }
+
+/** pico7219_isr_set_pixel() */
+BOOL pico7219_isr_set_pixel (struct Pico7219 *self, uint8_t row, 
+       uint16_t col, BOOL on)
+  {
+  uint32_t head = self->isr_head;
+  uint32_t tail = __atomic_load_n (&self->isr_tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= PICO7219_ISR_QUEUE) return FALSE;
+  self->isr_queue[head % PICO7219_ISR_QUEUE] = 
+    ((uint32_t)col << PICO7219_ISR_COL_SHIFT) | 
+    ((uint32_t)row << PICO7219_ISR_ROW_SHIFT) | (on ? PICO7219_ISR_ON : 0);
+  // Publish the entry only after it has been written
+  __atomic_store_n (&self->isr_head, head + 1, __ATOMIC_RELEASE);
+  return TRUE;
+  }
+
+/** pico7219_isr_apply() */
+void pico7219_isr_apply (struct Pico7219 *self)
+  {
+  // Take a snapshot of the head, so that updates queued while we work
+  //   wait for the next call, rather than making this call unbounded
+  uint32_t head = __atomic_load_n (&self->isr_head, __ATOMIC_ACQUIRE);
+  uint32_t tail = self->isr_tail;
+  while (tail != head)
+    {
+    uint32_t e = self->isr_queue[tail % PICO7219_ISR_QUEUE];
+    uint8_t row = (e >> PICO7219_ISR_ROW_SHIFT) & 0xFF;
+    uint16_t col = e >> PICO7219_ISR_COL_SHIFT;
+    // Entries outside the virtual chain are dropped
+    pico7219_put_pixel (self, row, col, e & PICO7219_ISR_ON);
+    tail++;
+    }
+  // Release the slots only after we have finished reading them
+  __atomic_store_n (&self->isr_tail, tail, __ATOMIC_RELEASE);
+  }
+
+/** Mark for the next flush the rows that have blinking pixels on the
+    display: in the visible part of the virtual chain, or in the part
+    of a zone's source that the zone shows. */
+static void pico7219_mark_blink_rows_dirty (struct Pico7219 *self)
+  {
+  int target_mods = self->chain_len;
+  if (target_mods > self->vchain_len) target_mods = self->vchain_len;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    if (!pico7219_row_blinks (self, row)) continue;
+    const uint8_t *b = pico7219_brow (self, row);
+    uint8_t zb[PICO7219_MAX_CHAIN] = {0};
+    // The blink plane goes through the zones as the flush sends it
+    if (self->zone_count) pico7219_zones_to_row (self, b, zb);
+    for (int i = 0; i < self->chain_len; i++)
+      {
+      if ((i < target_mods && b[i]) || zb[i])
+        {
+        self->row_dirty[row] = TRUE;
+        break;
+        }
+      }
+    }
+  }
+
+/** pico7219_set_blink() */
+void pico7219_set_blink (struct Pico7219 *self, uint8_t row, int col, 
+       BOOL blink)
+  {
+  pico7219_set_blink_rect (self, col, row, 1, 1, blink);
+  }
+
+/** pico7219_set_blink_rect() */
+void pico7219_set_blink_rect (struct Pico7219 *self, int x, int y, int w, 
+       int h, BOOL blink)
+  {
+  int width = PICO7219_COLS * self->vchain_len;
+  int x1 = x + w, y1 = y + h;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > width) x1 = width;
+  if (y1 > PICO7219_ROWS) y1 = PICO7219_ROWS;
+  if (x >= x1 || y >= y1) return;
+
+  for (int row = y; row < y1; row++)
+    {
+    uint8_t *b = pico7219_brow (self, row);
+    BOOL changed = FALSE;
+    for (int col = x; col < x1; col++)
+      {
+      uint8_t mask = 1 << (col % 8);
+      uint8_t nv = blink ? (b[col / 8] | mask) : (b[col / 8] & ~mask);
+      if (nv != b[col / 8])
+        {
+        b[col / 8] = nv;
+        changed = TRUE;
+        }
+      }
+    // Changing the attribute only changes the display in the off phase,
+    //   but the row is sent anyway, so the two phases don't get out 
+    //   of step
+    if (changed) self->row_dirty[row] = TRUE;
+    if (blink) 
+      self->blink_rows |= 1 << ((row + self->row_base) & 
+        (PICO7219_ROWS - 1));
+    }
+  }
+
+/** pico7219_clear_blink() */
+void pico7219_clear_blink (struct Pico7219 *self)
+  {
+  if (self->blink_off) pico7219_mark_blink_rows_dirty (self);
+  memset (self->blink, 0, PICO7219_ROWS * self->vchain_len);
+  self->blink_rows = 0;
+  }
+
+/** pico7219_set_blink_period() */
+void pico7219_set_blink_period (struct Pico7219 *self, uint32_t period_us)
+  {
+  self->blink_period = period_us < 2 ? 0 : period_us;
+  if (!self->blink_period && self->blink_off)
+    {
+    // Show the blinking pixels again
+    self->blink_off = FALSE;
+    pico7219_mark_blink_rows_dirty (self);
+    }
+  }
+
+/** Move the viewport of each scrolling zone by the number of columns
+    due since its last step, and mark all rows for the flush if any 
+    zone has moved. */
+static void pico7219_zones_step (struct Pico7219 *self)
+  {
+  uint32_t now = (uint32_t)pico7219_time_us ();
+  BOOL moved = FALSE;
+  for (int z = 0; z < self->zone_count; z++)
+    {
+    struct Pico7219Zone *zone = &self->zones[z];
+    if (!zone->speed) continue;
+    uint32_t step_time = 1000000 / abs (zone->speed);
+    uint32_t steps = (now - zone->step_us) / step_time;
+    if (!steps) continue;
+    zone->step_us += steps * step_time;
+    int64_t offset = zone->offset + 
+      (zone->speed > 0 ? (int64_t)steps : -(int64_t)steps);
+    if (zone->wrap)
+      offset %= zone->src_width;
+    else if (offset > zone->src_width)
+      offset = zone->src_width; // Scrolled out to the left; stop 
+    else if (offset < -zone->width)
+      offset = -zone->width; // Scrolled out to the right; stop
+    if (offset != zone->offset)
+      {
+      zone->offset = offset;
+      moved = TRUE;
+      }
+    }
+  if (moved) pico7219_mark_all_dirty (self);
+  }
+
+/** pico7219_flush_prepare() does the part of a flush that works out 
+    what has to be sent: it applies queued changes, and copies every
+    row of the virtual chain to self->data. The rows to be sent are 
+    the ones already marked dirty; nothing is compared here. */
+static void pico7219_flush_prepare (struct Pico7219 *self)
+  {
+  pico7219_isr_apply (self);
+  if (self->blink_period)
+    {
+    BOOL off = (pico7219_time_us () / (self->blink_period / 2)) & 1;
+    if (off != self->blink_off)
+      {
+      self->blink_off = off;
+      pico7219_mark_blink_rows_dirty (self);
+      }
+    }
+  if (self->zone_count) pico7219_zones_step (self);
+  for (int i = 0; i < PICO7219_ROWS; i++)
+    pico7219_vrow_to_row (self, i);
+  }
+
+/** pico7219_idle_skip() decides, in idle mode, whether a flush can 
+    be skipped. Returns TRUE if nothing needs to be sent: either no 
+    row is dirty, or the frame is the same as the one last sent, or the
+    frame is completely dark. A dark frame puts the chain into shutdown;
+    its rows, and any deferred intensity change, are left pending, so 
+    they are sent when the chain wakes. */
+static BOOL pico7219_idle_skip (struct Pico7219 *self)
+  {
+  if (!memchr (self->row_dirty, TRUE, sizeof (self->row_dirty)) &&
+      !self->intensity_pending) 
+    return TRUE;
+
+  // FNV-1a hash of the rows as they would be sent, noting on the way
+  //   whether any LED is lit
+  uint32_t hash = 2166136261u;
+  uint8_t lit = 0;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    for (int i = 0; i < self->chain_len; i++)
+      {
+      uint8_t v = self->data[row][i];
+      lit |= v;
+      hash = (hash ^ v) * 16777619u;
+      }
+    }
+  BOOL same = self->frame_hash_valid && hash == self->frame_hash;
+  self->frame_hash = hash;
+  self->frame_hash_valid = TRUE;
+
+  if (!lit)
+    {
+    if (!self->asleep)
+      {
+      pico7219_write_word_to_chain (self, PICO7219_SHUTDOWN_REG, 0x00); 
+      self->asleep = TRUE;
+      }
+    return TRUE;
+    }
+  if (same && !self->asleep && !self->intensity_pending)
+    {
+    memset (self->row_dirty, 0, sizeof (self->row_dirty));
+    return TRUE;
+    }
+  return FALSE;
+  }
+
+/** pico7219_flush_send() does the rest of a flush, writing to the
+    hardware the rows that are marked dirty. */
+static void pico7219_flush_send (struct Pico7219 *self)
+  {
+  PICO7219_TRACE_BEGIN (PICO7219_TRACE_FLUSH, 0);
+  if (self->idle && pico7219_idle_skip (self)) 
+    {
+    PICO7219_TRACE_END (PICO7219_TRACE_FLUSH, 0);
+    return;
+    }
+  if (self->current_budget) pico7219_apply_intensity (self, TRUE);
+  int sent = 0;
+  for (int i = 0; i < PICO7219_ROWS; i++)
+    {
+    if (self->row_dirty[i])
+      {
+      pico7219_set_row_bits (self, i, self->data[i]);
+      sent++;
+      }
+    self->row_dirty[i] = FALSE;
+    }
+  if (self->current_budget) pico7219_apply_intensity (self, FALSE);
+  // A deferred intensity change takes the place of the refresh step, 
+  //   which will be done at the next flush instead
+  if (self->intensity_pending)
+    {
+    self->intensity_pending = FALSE;
+    pico7219_set_intensity (self, self->pending_intensity);
+    }
+  else if (self->refresh) 
+    pico7219_refresh_step (self);
+  // Wake from idle shutdown only once the rows that changed while 
+  //   asleep have been sent, so the old frame is never shown
+  if (self->asleep)
+    {
+    pico7219_write_word_to_chain (self, PICO7219_SHUTDOWN_REG, 0x01); 
+    self->asleep = FALSE;
+    }
+  PICO7219_TRACE_END (PICO7219_TRACE_FLUSH, sent);
+  (void)sent;
+  }
+
+/** pico7219_flush() */
+void pico7219_flush (struct Pico7219 *self)
+  {
+  pico7219_flush_prepare (self);
+  pico7219_flush_send (self);
+  }
+
+/** pico7219_bus_create() */
+struct Pico7219Bus *pico7219_bus_create (enum PicoSpiNum spi_num, 
+         int32_t baud, uint8_t mosi, uint8_t sck)
+  {
+  struct Pico7219Bus *bus = malloc (sizeof (struct Pico7219Bus));
+  if (bus)
+    {
+    bus->spi_num = spi_num;
+    bus->count = 0;
+    bus->next = 0;
+    bus->order = PICO7219_BUS_ROUND_ROBIN;
+#if PICO_ON_DEVICE
+    bus->spi = pico7219_spi_setup (spi_num, baud, mosi, sck);
+#else
+    printf ("Init shared SPI %d at %d baud, mosi=%d, sck=%d\n", 
+      spi_num, baud, mosi, sck);
+#endif
+    }
+  return bus;
+  }
+
+/** pico7219_bus_destroy() */
+void pico7219_bus_destroy (struct Pico7219Bus *bus, BOOL deinit)
+  {
+  if (bus)
+    {
+    while (bus->count > 0)
+      pico7219_destroy (bus->displays[bus->count - 1], FALSE);
+    if (deinit)
+      {
+#if PICO_ON_DEVICE
+      spi_deinit (bus->spi);
+#endif
+      }
+    free (bus);
+    }
+  }
+
+/** pico7219_create_on_bus() */
+struct Pico7219 *pico7219_create_on_bus (struct Pico7219Bus *bus, 
+         uint8_t cs, uint8_t chain_len, BOOL reverse_bits)
+  {
+  if (chain_len > PICO7219_MAX_CHAIN) return NULL;
+  if (bus->count == PICO7219_BUS_MAX_DISPLAYS) return NULL;
+  struct Pico7219 *self = pico7219_alloc ();
+  if (self)
+    {
+    pico7219_setup (self, bus->spi_num, 0, 0, 0, cs, chain_len, 
+      reverse_bits, bus);
+    bus->displays[bus->count++] = self;
+    }
+  return self;
+  }
+
+/** pico7219_set_priority() */
+void pico7219_set_priority (struct Pico7219 *self, uint8_t priority)
+  {
+  self->priority = priority;
+  }
+
+/** pico7219_bus_set_order() */
+void pico7219_bus_set_order (struct Pico7219Bus *bus, 
+       enum Pico7219BusOrder order)
+  {
+  bus->order = order;
+  }
+
+/** pico7219_bus_flush(). All the displays are prepared first, so that
+    their transactions then go out one after another, with nothing but
+    the building of each transaction in between. */
+void pico7219_bus_flush (struct Pico7219Bus *bus)
+  {
+  struct Pico7219 *order[PICO7219_BUS_MAX_DISPLAYS];
+  int n = bus->count;
+  if (n == 0) return;
+  if (bus->order == PICO7219_BUS_PRIORITY)
+    {
+    // Insertion sort, which keeps displays of equal priority in the
+    //   order they were created
+    for (int i = 0; i < n; i++)
+      {
+      struct Pico7219 *d = bus->displays[i];
+      int j = i;
+      for (; j > 0 && order[j - 1]->priority < d->priority; j--)
+        order[j] = order[j - 1];
+      order[j] = d;
+      }
+    }
+  else
+    {
+    // Start one display further on each time, so that each takes its
+    //   turn at being first
+    for (int i = 0; i < n; i++)
+      order[i] = bus->displays[(bus->next + i) % n];
+    bus->next = (bus->next + 1) % n;
+    }
+
+  for (int i = 0; i < n; i++)
+    pico7219_flush_prepare (order[i]);
+  for (int i = 0; i < n; i++)
+    pico7219_flush_send (order[i]);
+  }
+
+/** pico7219_set_idle() */
+void pico7219_set_idle (struct Pico7219 *self, BOOL idle)
+  {
+  self->idle = idle;
+  // The data may have been sent without a hash being taken
+  self->frame_hash_valid = FALSE;
+  }
+
+/** pico7219_zone_create() */
+int pico7219_zone_create (struct Pico7219 *self, int first_col, int width,
+      int src_col, int src_width)
+  {
+  if (self->zone_count >= PICO7219_MAX_ZONES) return -1;
+  if (first_col < 0 || width <= 0 || 
+      first_col + width > PICO7219_COLS * self->chain_len) return -1;
+  if (src_col < 0 || src_width <= 0 || 
+      src_col + src_width > PICO7219_COLS * self->vchain_len) return -1;
+  struct Pico7219Zone *zone = &self->zones[self->zone_count];
+  zone->first_col = first_col;
+  zone->width = width;
+  zone->src_col = src_col;
+  zone->src_width = src_width;
+  zone->offset = 0;
+  zone->speed = 0;
+  zone->wrap = FALSE;
+  zone->step_us = 0;
+  pico7219_mark_all_dirty (self);
+  return self->zone_count++;
+  }
+
+/** pico7219_zone_set_offset() */
+void pico7219_zone_set_offset (struct Pico7219 *self, int zone, 
+      int offset, BOOL flush)
+  {
+  if (zone < 0 || zone >= self->zone_count) return;
+  struct Pico7219Zone *z = &self->zones[zone];
+  if (z->wrap) offset %= z->src_width;
+  if (offset != z->offset)
+    {
+    z->offset = offset;
+    pico7219_mark_all_dirty (self);
+    }
+  if (flush) pico7219_flush (self);
+  }
+
+/** pico7219_zone_get_offset() */
+int pico7219_zone_get_offset (const struct Pico7219 *self, int zone)
+  {
+  if (zone < 0 || zone >= self->zone_count) return 0;
+  return self->zones[zone].offset;
+  }
+
+/** pico7219_zone_set_scroll() */
+void pico7219_zone_set_scroll (struct Pico7219 *self, int zone, 
+      int speed, BOOL wrap)
+  {
+  if (zone < 0 || zone >= self->zone_count) return;
+  struct Pico7219Zone *z = &self->zones[zone];
+  if (speed > INT16_MAX) speed = INT16_MAX;
+  if (speed < -INT16_MAX) speed = -INT16_MAX;
+  z->speed = speed;
+  if (wrap != z->wrap) pico7219_mark_all_dirty (self);
+  z->wrap = wrap;
+  z->step_us = (uint32_t)pico7219_time_us ();
+  }
+
+/** pico7219_zone_clear_all() */
+void pico7219_zone_clear_all (struct Pico7219 *self)
+  {
+  if (self->zone_count) pico7219_mark_all_dirty (self);
+  self->zone_count = 0;
+  }
+
+/** pico7219_set_refresh() */
+void pico7219_set_refresh (struct Pico7219 *self, BOOL refresh)
+  {
+  self->refresh = refresh;
+  }
+
+/** pico7219_refresh_step() */
+void pico7219_refresh_step (struct Pico7219 *self)
+  {
+  int step = self->refresh_step;
+  if (step < PICO7219_REFRESH_CONTROL_STEPS)
+    {
+    uint8_t buf[PICO7219_TRANSACTION_MAX];
+    pico7219_fill_control_reg (self, buf, step);
+    pico7219_write_transaction (self, buf);
+    }
+  else
+    {
+    // Re-send the row as the last flush prepared it, not as it is now
+    //   in the virtual chain, which may have unflushed changes. That
+    //   is the row last sent, except while idle mode has the chain 
+    //   asleep, when it is the dark frame that was not sent; the 
+    //   chain is shut down then, so it is not shown
+    int row = step - PICO7219_REFRESH_CONTROL_STEPS;
+    pico7219_set_row_bits (self, row, self->data[row]);
+    }
+  self->refresh_step = (step + 1) % PICO7219_REFRESH_STEPS;
+  }
+
+/** pico7219_set_intensity() */
+void pico7219_set_intensity (struct Pico7219 *self, uint8_t intensity)
+  {
+  self->intensity = intensity & 0x0F;
+  if (self->current_budget)
+    {
+    // Only the data that has been flushed is on the display, so that's
+    //   what the limit applies to
+    pico7219_apply_intensity (self, FALSE);
+    }
+  else
+    {
+    memset (self->sent_intensity, self->intensity, 
+      sizeof (self->sent_intensity));
+    pico7219_write_word_to_chain (self, PICO7219_INTENSITY_REG, 
+      self->intensity); 
+    }
+  }
+
+/** pico7219_set_intensity_deferred() */
+void pico7219_set_intensity_deferred (struct Pico7219 *self, 
+       uint8_t intensity)
+  {
+  self->pending_intensity = intensity;
+  self->intensity_pending = TRUE;
+  }
+
+/** pico7219_set_current_limit() */
+void pico7219_set_current_limit (struct Pico7219 *self, uint16_t budget,
+        BOOL per_module)
+  {
+  self->current_budget = budget;
+  self->budget_per_module = per_module;
+  pico7219_apply_intensity (self, FALSE);
+  }
+
+
+
+/** pico7219_configure_module() */
+void pico7219_configure_module (struct Pico7219 *self, uint8_t module,
+        enum Pico7219ModuleMode mode, uint8_t decode, uint8_t scan_limit)
+  {
+  if (module >= self->chain_len) return;
+  self->module_mode[module] = mode;
+  self->decode[module] = decode;
+  self->scan_limit[module] = scan_limit & 0x07;
+  pico7219_write_reg_per_module (self, PICO7219_DECODE_REG, self->decode);
+  pico7219_write_reg_per_module (self, PICO7219_SCAN_LIMIT_REG, 
+    self->scan_limit);
+  }
+
+// Segment patterns for the letters A-Z, for digits where Code B can't
+//   be used. The bits are DP,A,B,C,D,E,F,G from MSB to LSB. Some 
+//   letters can only be approximated on seven segments.
+static const uint8_t pico7219_seg_letters[26] = 
+  {
+  0x77, 0x1F, 0x4E, 0x3D, 0x4F, 0x47, 0x5E, 0x37, 0x06, 0x3C, // A-J
+  0x37, 0x0E, 0x76, 0x15, 0x1D, 0x67, 0x73, 0x05, 0x5B, 0x0F, // K-T
+  0x3E, 0x1C, 0x2A, 0x37, 0x3B, 0x6D                          // U-Z
+  };
+
+/** Work out how to show a character on a 7-segment digit. Returns TRUE
+    and sets *code if the character has a Code B value, which the
+    MAX7219 will decode itself. Otherwise returns FALSE and sets *code
+    to the raw segment pattern. */
+static BOOL pico7219_char_to_digit (char c, uint8_t *code)
+  {
+  if (c >= '0' && c <= '9') { *code = c - '0'; return TRUE; }
+  if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+  switch (c)
+    {
+    case '-': *code = PICO7219_CODEB_MINUS; return TRUE;
+    case 'E': *code = 0x0B; return TRUE;
+    case 'H': *code = 0x0C; return TRUE;
+    case 'L': *code = 0x0D; return TRUE;
+    case 'P': *code = 0x0E; return TRUE;
+    case ' ': *code = PICO7219_CODEB_BLANK; return TRUE;
+    case '_': *code = 0x08; return FALSE;
+    case '=': *code = 0x09; return FALSE;
+    case '"': *code = 0x22; return FALSE;
+    case '\'': *code = 0x02; return FALSE;
+    case '?': *code = 0x65; return FALSE;
+    case '[': *code = 0x4E; return FALSE;
+    case ']': *code = 0x78; return FALSE;
+    }
+  if (c >= 'A' && c <= 'Z') 
+    *code = pico7219_seg_letters[c - 'A'];
+  else
+    *code = 0x00;
+  return FALSE;
+  }
+
+/** Set the value of one digit register in the virtual chain, marking
+    the row dirty only if it changes. */
+static void pico7219_set_digit (struct Pico7219 *self, uint8_t module, 
+        int digit, uint8_t v)
+  {
+  uint8_t *b = pico7219_vrow (self, digit) + module;
+  if (*b != v)
+    {
+    *b = v;
+    self->row_dirty[digit] = TRUE;
+    }
+  }
+
+/** Change the decode mode of one module, writing it to the hardware
+    only if it has changed. */
+static void pico7219_set_decode (struct Pico7219 *self, uint8_t module, 
+        uint8_t decode)
+  {
+  if (self->decode[module] != decode)
+    {
+    self->decode[module] = decode;
+    pico7219_write_reg_per_module (self, PICO7219_DECODE_REG, self->decode);
+    }
+  }
+
+/** pico7219_display_number() */
+void pico7219_display_number (struct Pico7219 *self, uint8_t module, 
+        int32_t value, BOOL flush)
+  {
+  if (module >= self->chain_len || module >= self->vchain_len) return;
+  int digits = self->scan_limit[module] + 1;
+  BOOL negative = value < 0;
+  // Work with the magnitude as unsigned, so INT32_MIN is safe
+  uint32_t v = negative ? -(uint32_t)value : (uint32_t)value;
+
+  uint8_t codes[PICO7219_ROWS];
+  int n = 0;
+  do
+    {
+    codes[n++] = v % 10;
+    v /= 10;
+    } while (v && n < digits);
+  if (negative && n < digits) 
+    codes[n++] = PICO7219_CODEB_MINUS;
+
+  if (v || (negative && codes[n - 1] != PICO7219_CODEB_MINUS))
+    {
+    // Doesn't fit -- show dashes, rather than a misleading number
+    for (n = 0; n < digits; n++) codes[n] = PICO7219_CODEB_MINUS;
+    }
+  while (n < digits) 
+    codes[n++] = PICO7219_CODEB_BLANK;
+
+  pico7219_set_decode (self, module, 0xFF);
+  for (int i = 0; i < digits; i++)
+    pico7219_set_digit (self, module, i, codes[i]);
+  if (flush) pico7219_flush (self);
+  }
+
+/** pico7219_display_string() */
+void pico7219_display_string (struct Pico7219 *self, uint8_t module, 
+        const char *s, BOOL flush)
+  {
+  if (module >= self->chain_len || module >= self->vchain_len) return;
+  int digits = self->scan_limit[module] + 1;
+  uint8_t decode = 0;
+
+  // Digits are numbered from the right, so the first character goes
+  //   in the highest digit.
+  int digit = digits;
+  while (*s && digit > 0)
+    {
+    uint8_t code;
+    if (*s == '.')
+      code = PICO7219_CODEB_BLANK, decode |= 1 << (digit - 1);
+    else if (pico7219_char_to_digit (*s, &code))
+      decode |= 1 << (digit - 1);
+    s++;
+    // A following decimal point goes in the same digit
+    if (*s == '.')
+      {
+      code |= PICO7219_SEG_DP;
+      s++;
+      }
+    pico7219_set_digit (self, module, --digit, code);
+    }
+  while (digit > 0)
+    {
+    decode |= 1 << (digit - 1);
+    pico7219_set_digit (self, module, --digit, PICO7219_CODEB_BLANK);
+    }
+
+  // Digits beyond the scan limit are not displayed, so their decode 
+  //   bits don't matter; keep them as they were to avoid needless writes
+  uint8_t scanned = (uint8_t)((1 << digits) - 1);
+  pico7219_set_decode (self, module, 
+    (self->decode[module] & ~scanned) | (decode & scanned));
+  if (flush) pico7219_flush (self);
+  }
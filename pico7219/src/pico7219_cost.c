@@ -0,0 +1,112 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_cost.c
+
+  A model of the time taken by display updates. See pico7219_cost.h.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <string.h>
+#include "pico7219/pico7219_cost.h"
+
+/** pico7219_cost_actual_baud() */
+uint32_t pico7219_cost_actual_baud (uint32_t baud)
+  {
+  // This is the search that the Pico SDK's spi_set_baudrate() does: 
+  //   the smallest even prescaler that allows the rate to be reached,
+  //   then the smallest post-divider that doesn't exceed it
+  uint32_t freq_in = PICO7219_COST_CLK_PERI;
+  uint32_t prescale, postdiv;
+  if (baud == 0) return 0;
+  for (prescale = 2; prescale <= 254; prescale += 2) 
+    {
+    if (freq_in < (prescale + 2) * 256 * (uint64_t)baud) break;
+    }
+  if (prescale > 254) return 0; // Too slow to be possible
+  for (postdiv = 256; postdiv > 1; --postdiv) 
+    {
+    if (freq_in / (prescale * (postdiv - 1)) > baud) break;
+    }
+  return freq_in / (prescale * postdiv);
+  }
+
+/** Fill in the estimate, given the number of transactions and the
+    processor time outside them. */
+static void pico7219_cost_finish (const struct Pico7219CostParams *params,
+        uint32_t transactions, uint64_t cpu_ns, 
+        struct Pico7219CostEstimate *estimate)
+  {
+  uint32_t bytes_per = 2 * params->chain_len;
+  uint32_t baud = pico7219_cost_actual_baud (params->baud);
+
+  cpu_ns += (uint64_t)transactions * (PICO7219_COST_NS_TRANSACTION + 
+    bytes_per * (PICO7219_COST_NS_BYTE + 
+      (params->reverse_bits ? PICO7219_COST_NS_REVERSE : 0)));
+
+  memset (estimate, 0, sizeof (*estimate));
+  estimate->cs_cycles = transactions;
+  estimate->bytes = transactions * bytes_per;
+  if (baud) 
+    estimate->wire_us = ((uint64_t)estimate->bytes * 8 * 1000000 + 
+      baud - 1) / baud;
+  estimate->cpu_us = (cpu_ns + 999) / 1000;
+  estimate->total_us = estimate->wire_us + estimate->cpu_us;
+  if (estimate->total_us)
+    estimate->max_fps = 1000000 / estimate->total_us;
+  }
+
+/** pico7219_cost_flush() */
+void pico7219_cost_flush (const struct Pico7219CostParams *params,
+       struct Pico7219CostEstimate *estimate)
+  {
+  int rows = params->rows;
+  if (rows < 0) rows = 0;
+  if (rows > PICO7219_ROWS) rows = PICO7219_ROWS;
+  uint32_t transactions = rows;
+  if (params->refresh) transactions++;
+  if (params->current_limit) transactions += 2;
+  // Every flush copies every row of the physical chain out of the 
+  //   virtual chain, whether it is dirty or not; which rows are sent
+  //   depends only on the dirty flags
+  uint64_t cpu_ns = (uint64_t)PICO7219_ROWS * (PICO7219_COST_NS_ROW + 
+    params->chain_len * PICO7219_COST_NS_COPY);
+  pico7219_cost_finish (params, transactions, cpu_ns, estimate);
+  }
+
+/** pico7219_cost_scroll() */
+void pico7219_cost_scroll (const struct Pico7219CostParams *params,
+       BOOL horizontal, struct Pico7219CostEstimate *estimate)
+  {
+  struct Pico7219CostParams p = *params;
+  p.rows = PICO7219_ROWS;
+  pico7219_cost_flush (&p, estimate);
+  if (horizontal)
+    {
+    uint64_t cpu_ns = (uint64_t)estimate->cpu_us * 1000 + 
+      (uint64_t)PICO7219_ROWS * p.vchain_len * PICO7219_COST_NS_SHIFT;
+    estimate->cpu_us = (cpu_ns + 999) / 1000;
+    estimate->total_us = estimate->wire_us + estimate->cpu_us;
+    estimate->max_fps = estimate->total_us ? 
+      1000000 / estimate->total_us : 0;
+    }
+  }
+
+/** pico7219_cost_measure_flush() */
+uint32_t pico7219_cost_measure_flush (struct Pico7219 *display, 
+       int rows, int count)
+  {
+  if (count <= 0) return 0;
+  if (rows > PICO7219_ROWS) rows = PICO7219_ROWS;
+  uint64_t start = pico7219_time_us ();
+  for (int i = 0; i < count; i++)
+    {
+    for (int row = 0; row < rows; row++)
+      pico7219_mark_row_dirty (display, row);
+    pico7219_flush (display);
+    }
+  return (pico7219_time_us () - start) / count;
+  }
+
@@ -0,0 +1,215 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_dl.c
+
+  Recording and replaying display lists. See pico7219_dl.h for a 
+  description of the format.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <string.h>
+#include "pico7219/pico7219_dl.h"
+
+/** pico7219_dl_init() */
+void pico7219_dl_init (struct Pico7219DisplayList *dl, uint8_t *buf,
+       uint16_t capacity)
+  {
+  dl->buf = buf;
+  dl->capacity = capacity;
+  pico7219_dl_reset (dl);
+  }
+
+/** pico7219_dl_reset() */
+void pico7219_dl_reset (struct Pico7219DisplayList *dl)
+  {
+  dl->len = 0;
+  dl->overflow = FALSE;
+  }
+
+/** Reserve n bytes at the end of the list, returning a pointer to them,
+    or NULL if there isn't room. */
+static uint8_t *pico7219_dl_reserve (struct Pico7219DisplayList *dl, 
+        int n)
+  {
+  if (dl->len + n > dl->capacity)
+    {
+    dl->overflow = TRUE;
+    return NULL;
+    }
+  uint8_t *p = dl->buf + dl->len;
+  dl->len += n;
+  return p;
+  }
+
+/** Store a 16-bit little-endian value, returning the next position. */
+static inline uint8_t *pico7219_dl_put16 (uint8_t *p, int v)
+  {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  return p + 2;
+  }
+
+/** Read a signed 16-bit little-endian value. */
+static inline int pico7219_dl_get16 (const uint8_t *p)
+  {
+  return (int16_t)(p[0] | (p[1] << 8));
+  }
+
+/** pico7219_dl_clear() */
+BOOL pico7219_dl_clear (struct Pico7219DisplayList *dl)
+  {
+  uint8_t *p = pico7219_dl_reserve (dl, 1);
+  if (!p) return FALSE;
+  *p = PICO7219_DL_CLEAR;
+  return TRUE;
+  }
+
+/** pico7219_dl_pixel() */
+BOOL pico7219_dl_pixel (struct Pico7219DisplayList *dl, int x, int y, 
+       BOOL on)
+  {
+  uint8_t *p = pico7219_dl_reserve (dl, 5);
+  if (!p) return FALSE;
+  *p++ = PICO7219_DL_PIXEL;
+  p = pico7219_dl_put16 (p, x);
+  *p++ = y;
+  *p = on ? 1 : 0;
+  return TRUE;
+  }
+
+/** pico7219_dl_rect() */
+BOOL pico7219_dl_rect (struct Pico7219DisplayList *dl, int x, int y, 
+       int w, int h, BOOL on)
+  {
+  uint8_t *p = pico7219_dl_reserve (dl, 8);
+  if (!p) return FALSE;
+  *p++ = PICO7219_DL_RECT;
+  p = pico7219_dl_put16 (p, x);
+  *p++ = (uint8_t)(int8_t)y;
+  p = pico7219_dl_put16 (p, w);
+  *p++ = h;
+  *p = on ? 1 : 0;
+  return TRUE;
+  }
+
+/** pico7219_dl_blit() */
+BOOL pico7219_dl_blit (struct Pico7219DisplayList *dl, int x, 
+       const uint8_t *columns, int n)
+  {
+  if (n < 0 || n > 255) return FALSE;
+  uint8_t *p = pico7219_dl_reserve (dl, 4 + n);
+  if (!p) return FALSE;
+  *p++ = PICO7219_DL_BLIT;
+  p = pico7219_dl_put16 (p, x);
+  *p++ = n;
+  memcpy (p, columns, n);
+  return TRUE;
+  }
+
+/** pico7219_dl_text() */
+BOOL pico7219_dl_text (struct Pico7219DisplayList *dl, int x, 
+       const char *s)
+  {
+  size_t n = strlen (s);
+  if (n > 255) return FALSE;
+  uint8_t *p = pico7219_dl_reserve (dl, 4 + n);
+  if (!p) return FALSE;
+  *p++ = PICO7219_DL_TEXT;
+  p = pico7219_dl_put16 (p, x);
+  *p++ = n;
+  memcpy (p, s, n);
+  return TRUE;
+  }
+
+/** pico7219_dl_scroll() */
+BOOL pico7219_dl_scroll (struct Pico7219DisplayList *dl, int dx, int dy, 
+       BOOL wrap)
+  {
+  uint8_t *p = pico7219_dl_reserve (dl, 5);
+  if (!p) return FALSE;
+  *p++ = PICO7219_DL_SCROLL;
+  p = pico7219_dl_put16 (p, dx);
+  *p++ = (uint8_t)(int8_t)dy;
+  *p = wrap ? 1 : 0;
+  return TRUE;
+  }
+
+/** pico7219_dl_replay() */
+BOOL pico7219_dl_replay (struct Pico7219 *display, const uint8_t *buf, 
+       uint16_t len, const struct Pico7219Font *font, BOOL flush)
+  {
+  const uint8_t *p = buf;
+  const uint8_t *end = buf + len;
+  BOOL ok = TRUE;
+  while (ok && p < end)
+    {
+    int remaining = end - p;
+    switch (*p)
+      {
+      case PICO7219_DL_CLEAR:
+        pico7219_switch_off_all (display, FALSE);
+        p += 1;
+        break;
+
+      case PICO7219_DL_PIXEL:
+        if (remaining < 5) { ok = FALSE; break; }
+        // x may be negative, or beyond column 255 of a long virtual 
+        //   chain, so it mustn't be narrowed; set_pixel() clips it
+        pico7219_set_pixel (display, p[3], pico7219_dl_get16 (p + 1), 
+          p[4], FALSE);
+        p += 5;
+        break;
+
+      case PICO7219_DL_RECT:
+        if (remaining < 8) { ok = FALSE; break; }
+        pico7219_fill_rect (display, pico7219_dl_get16 (p + 1), 
+          (int8_t)p[3],
+          pico7219_dl_get16 (p + 4), p[6], p[7], FALSE);
+        p += 8;
+        break;
+
+      case PICO7219_DL_BLIT:
+        {
+        if (remaining < 4 || remaining < 4 + p[3]) { ok = FALSE; break; }
+        int x = pico7219_dl_get16 (p + 1);
+        for (int i = 0; i < p[3]; i++)
+          pico7219_set_column (display, x + i, p[4 + i], FALSE);
+        p += 4 + p[3];
+        break;
+        }
+
+      case PICO7219_DL_TEXT:
+        {
+        if (remaining < 4 || remaining < 4 + p[3] || !font) 
+          { 
+          ok = FALSE; 
+          break; 
+          }
+        // The text isn't terminated in the list, so copy it out
+        char text[256];
+        memcpy (text, p + 4, p[3]);
+        text[p[3]] = 0;
+        pico7219_draw_text (display, font, pico7219_dl_get16 (p + 1), 
+          text, FALSE);
+        p += 4 + p[3];
+        break;
+        }
+
+      case PICO7219_DL_SCROLL:
+        if (remaining < 5) { ok = FALSE; break; }
+        pico7219_move (display, pico7219_dl_get16 (p + 1), (int8_t)p[3], 
+          p[4]);
+        p += 5;
+        break;
+
+      default:
+        ok = FALSE;
+      }
+    }
+  if (flush) pico7219_flush (display);
+  return ok;
+  }
+
@@ -0,0 +1,111 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_field.c
+
+  Text fields that redraw only the characters that change. See 
+  pico7219_field.h.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <string.h>
+#include "pico7219/pico7219_field.h"
+
+/** pico7219_field_init() */
+void pico7219_field_init (struct Pico7219Field *field, 
+       struct Pico7219 *display, const struct Pico7219Font *font,
+       int x, int y, int cells, int cell_width, int h)
+  {
+  if (cells > PICO7219_FIELD_MAX_CELLS) cells = PICO7219_FIELD_MAX_CELLS;
+  if (cells < 0) cells = 0;
+  field->display = display;
+  field->font = font;
+  field->x = x;
+  field->y = y;
+  field->cell_width = cell_width > 0 ? cell_width : 1;
+  field->cells = cells;
+  field->mask = 0;
+  for (int row = y; row < y + h; row++)
+    {
+    if (row >= 0 && row < PICO7219_ROWS) field->mask |= 1 << row;
+    }
+  field->valid = FALSE;
+  }
+
+/** pico7219_field_invalidate() */
+void pico7219_field_invalidate (struct Pico7219Field *field)
+  {
+  field->valid = FALSE;
+  }
+
+/** Write one column of a cell, changing only the rows of the 
+    rectangle. A row is marked for the next flush only if it changes. */
+static void pico7219_field_put_column (struct Pico7219Field *field, 
+        int col, uint8_t bits)
+  {
+  struct Pico7219 *display = field->display;
+  if (col < 0 || col >= PICO7219_COLS * 
+       pico7219_get_virtual_chain_length (display)) 
+    return;
+  uint8_t v = 1 << (col % 8);
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    if (!(field->mask & (1 << row))) continue;
+    uint8_t *b = pico7219_get_row_buffer (display, row) + col / 8;
+    uint8_t nv = (bits & (1 << row)) ? (*b | v) : (*b & ~v);
+    if (nv != *b)
+      {
+      *b = nv;
+      pico7219_mark_row_dirty (display, row);
+      }
+    }
+  }
+
+/** Draw one cell, with the glyph for c centred in it, and its row 0 on
+    the bottom row of the rectangle. */
+static void pico7219_field_draw_cell (struct Pico7219Field *field, 
+        int cell, uint32_t c)
+  {
+  const uint8_t *columns = NULL;
+  int width = c ? pico7219_font_glyph (field->font, c, &columns) : 0;
+  if (width < 0) width = 0;
+  int left = (field->cell_width - width) / 2;
+  if (left < 0) left = 0;
+  int x = field->x + cell * field->cell_width;
+  for (int i = 0; i < field->cell_width; i++)
+    {
+    int g = i - left;
+    uint8_t bits = 0;
+    if (g >= 0 && g < width)
+      {
+      // Rows shifted beyond either end of the display are dropped
+      int y = field->y;
+      if (y > -PICO7219_ROWS && y < PICO7219_ROWS)
+        bits = y >= 0 ? columns[g] << y : columns[g] >> -y;
+      }
+    pico7219_field_put_column (field, x + i, bits);
+    }
+  }
+
+/** pico7219_field_set() */
+int pico7219_field_set (struct Pico7219Field *field, const char *s,
+       BOOL flush)
+  {
+  int drawn = 0;
+  for (int i = 0; i < field->cells; i++)
+    {
+    uint32_t c = *s ? pico7219_utf8_next (&s) : 0;
+    if (!field->valid || c != field->text[i])
+      {
+      pico7219_field_draw_cell (field, i, c);
+      field->text[i] = c;
+      drawn++;
+      }
+    }
+  field->valid = TRUE;
+  if (flush) pico7219_flush (field->display);
+  return drawn;
+  }
+
@@ -0,0 +1,130 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_font.c
+
+  Drawing text using fonts compiled by the fontc tool. See 
+  pico7219_font.h for a description of the font format.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include "pico7219/pico7219_font.h"
+
+/** Get the offset of glyph g in the font's column table. */
+static inline int pico7219_font_offset (const struct Pico7219Font *font, 
+        int g)
+  {
+  return font->blocks[g / PICO7219_FONT_BLOCK] + font->offsets[g];
+  }
+
+/** pico7219_utf8_next() */
+uint32_t pico7219_utf8_next (const char **s)
+  {
+  const uint8_t *p = (const uint8_t *)*s;
+  uint32_t c = p[0];
+  if (c == 0) return 0;
+  int extra; // Number of continuation bytes
+  uint32_t min; // Smallest code point that needs this many bytes
+  if (c < 0x80) { *s += 1; return c; }
+  else if ((c & 0xE0) == 0xC0) { extra = 1; min = 0x80; c &= 0x1F; }
+  else if ((c & 0xF0) == 0xE0) { extra = 2; min = 0x800; c &= 0x0F; }
+  else if ((c & 0xF8) == 0xF0) { extra = 3; min = 0x10000; c &= 0x07; }
+  else { *s += 1; return 0xFFFD; }
+
+  for (int i = 1; i <= extra; i++)
+    {
+    // This also stops at the terminating zero
+    if ((p[i] & 0xC0) != 0x80) { *s += 1; return 0xFFFD; }
+    c = (c << 6) | (p[i] & 0x3F);
+    }
+  // Reject overlong encodings, surrogates, and values beyond Unicode
+  if (c < min || (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) 
+    { 
+    *s += 1; 
+    return 0xFFFD; 
+    }
+  *s += 1 + extra;
+  return c;
+  }
+
+/** Find the glyph number for character c, or -1 if there isn't one. 
+    Characters in the dense range are found directly, and others by
+    binary search of the extra code points. */
+static int pico7219_font_find (const struct Pico7219Font *font, uint32_t c)
+  {
+  if (c >= font->first && c - font->first < font->count) 
+    return c - font->first;
+  int lo = 0, hi = font->extra_count - 1;
+  while (lo <= hi)
+    {
+    int mid = (lo + hi) / 2;
+    uint32_t code = font->extra_codes[mid];
+    if (code == c) return font->count + mid;
+    if (code < c) 
+      lo = mid + 1;
+    else
+      hi = mid - 1;
+    }
+  return -1;
+  }
+
+/** pico7219_font_glyph() */
+int pico7219_font_glyph (const struct Pico7219Font *font, uint32_t c, 
+       const uint8_t **columns)
+  {
+  int g = pico7219_font_find (font, c);
+  if (g < 0) return -1;
+  int offset = pico7219_font_offset (font, g);
+  *columns = font->columns + offset;
+  return pico7219_font_offset (font, g + 1) - offset;
+  }
+
+/** pico7219_font_char_width() */
+int pico7219_font_char_width (const struct Pico7219Font *font, uint32_t c)
+  {
+  const uint8_t *columns;
+  int width = pico7219_font_glyph (font, c, &columns);
+  if (width <= 0) width = font->blank_width;
+  return width + font->spacing;
+  }
+
+/** pico7219_font_text_width() */
+int pico7219_font_text_width (const struct Pico7219Font *font, 
+       const char *s)
+  {
+  int width = 0;
+  uint32_t c;
+  while ((c = pico7219_utf8_next (&s)) != 0)
+    width += pico7219_font_char_width (font, c);
+  return width;
+  }
+
+/** pico7219_draw_char() */
+int pico7219_draw_char (struct Pico7219 *display, 
+       const struct Pico7219Font *font, int x, uint32_t c)
+  {
+  const uint8_t *columns;
+  int width = pico7219_font_glyph (font, c, &columns);
+  int advance = pico7219_font_char_width (font, c);
+  int i = 0;
+  for (; i < width; i++)
+    pico7219_set_column (display, x + i, columns[i], FALSE);
+  for (; i < advance; i++)
+    pico7219_set_column (display, x + i, 0, FALSE);
+  return advance;
+  }
+
+/** pico7219_draw_text() */
+int pico7219_draw_text (struct Pico7219 *display, 
+       const struct Pico7219Font *font, int x, const char *s, BOOL flush)
+  {
+  int start = x;
+  uint32_t c;
+  while ((c = pico7219_utf8_next (&s)) != 0)
+    x += pico7219_draw_char (display, font, x, c);
+  if (flush) pico7219_flush (display);
+  return x - start;
+  }
+
@@ -0,0 +1,268 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_fx.c
+
+  Transition effects. See pico7219_fx.h.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdlib.h>
+#include <string.h>
+#include "pico7219/pico7219_fx.h"
+
+// The kind of transition in progress, in addition to the wipe 
+//   directions
+#define PICO7219_FX_NONE -1
+#define PICO7219_FX_DISSOLVE -2
+
+struct Pico7219Fx
+  {
+  struct Pico7219 *display;
+  int width; // Columns in the physical display
+  // Pixel numbers (row * width + column) in the order a dissolve 
+  //   changes them
+  uint16_t *order; 
+  // The fade in progress, if fade_ticks is not zero
+  uint8_t fade_from;
+  uint8_t fade_to;
+  int fade_ticks;
+  int fade_tick;
+  uint8_t fade_level; // Last intensity written
+  // The wipe or dissolve in progress
+  int transition; 
+  const uint8_t *target;
+  int stride; // Bytes in each row of target: the virtual chain length
+  int speed;
+  int done; // Columns, rows or pixels changed so far
+  };
+
+/** Get the number of columns in the visible part of the display, 
+    which is the whole physical chain, unless the virtual chain is 
+    shorter. */
+static int pico7219_fx_visible_width (const struct Pico7219Fx *self)
+  {
+  int modules = pico7219_get_chain_length (self->display);
+  if (modules > pico7219_get_virtual_chain_length (self->display))
+    modules = pico7219_get_virtual_chain_length (self->display);
+  return PICO7219_COLS * modules;
+  }
+
+/** Make the width, and the dissolve order, match the visible part of
+    the display, which changes if the application changes the virtual
+    chain length to less than the physical chain. Returns FALSE if 
+    there is not enough memory, in which case nothing is changed. */
+static BOOL pico7219_fx_sync (struct Pico7219Fx *self)
+  {
+  int width = pico7219_fx_visible_width (self);
+  if (self->order && width == self->width) return TRUE;
+  int pixels = PICO7219_ROWS * width;
+  uint16_t *order = malloc (pixels * sizeof (uint16_t));
+  if (!order) return FALSE;
+  // Fisher-Yates shuffle, using a fixed xorshift generator so that 
+  //   the result doesn't depend on the C library
+  uint32_t x = 0x7219;
+  for (int i = 0; i < pixels; i++) order[i] = i;
+  for (int i = pixels - 1; i > 0; i--)
+    {
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    int j = x % (i + 1);
+    uint16_t t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+    }
+  free (self->order);
+  self->order = order;
+  self->width = width;
+  return TRUE;
+  }
+
+/** pico7219_fx_create() */
+struct Pico7219Fx *pico7219_fx_create (struct Pico7219 *display)
+  {
+  struct Pico7219Fx *self = malloc (sizeof (struct Pico7219Fx));
+  if (self)
+    {
+    memset (self, 0, sizeof (*self));
+    self->display = display;
+    self->transition = PICO7219_FX_NONE;
+    if (!pico7219_fx_sync (self))
+      {
+      free (self);
+      return NULL;
+      }
+    }
+  return self;
+  }
+
+/** pico7219_fx_destroy() */
+void pico7219_fx_destroy (struct Pico7219Fx *self)
+  {
+  if (self)
+    {
+    free (self->order);
+    free (self);
+    }
+  }
+
+/** pico7219_fx_fade() */
+void pico7219_fx_fade (struct Pico7219Fx *self, uint8_t from, uint8_t to, 
+       int ticks)
+  {
+  self->fade_from = from & 0x0F;
+  self->fade_to = to & 0x0F;
+  self->fade_ticks = ticks > 0 ? ticks : 1;
+  self->fade_tick = 0;
+  // Make sure the first step is written, even if it's "from"
+  self->fade_level = 0xFF;
+  }
+
+/** Start a wipe or dissolve. */
+static void pico7219_fx_start (struct Pico7219Fx *self, int transition,
+        const uint8_t *target, int speed)
+  {
+  self->transition = PICO7219_FX_NONE;
+  if (!pico7219_fx_sync (self)) return;
+  self->transition = transition;
+  self->target = target;
+  self->stride = pico7219_get_virtual_chain_length (self->display);
+  self->speed = speed > 0 ? speed : 1;
+  self->done = 0;
+  }
+
+/** pico7219_fx_wipe() */
+void pico7219_fx_wipe (struct Pico7219Fx *self, const uint8_t *target, 
+       enum Pico7219FxWipe direction, int speed)
+  {
+  pico7219_fx_start (self, direction, target, speed);
+  }
+
+/** pico7219_fx_dissolve() */
+void pico7219_fx_dissolve (struct Pico7219Fx *self, const uint8_t *target, 
+       int speed)
+  {
+  pico7219_fx_start (self, PICO7219_FX_DISSOLVE, target, speed);
+  }
+
+/** pico7219_fx_stop() */
+void pico7219_fx_stop (struct Pico7219Fx *self)
+  {
+  self->fade_ticks = 0;
+  self->transition = PICO7219_FX_NONE;
+  }
+
+/** Get a column of the target image, with row 0 in the LSB, as 
+    pico7219_set_column() takes it. */
+static uint8_t pico7219_fx_target_column (const struct Pico7219Fx *self,
+        int col)
+  {
+  uint8_t mask = 1 << (col % 8);
+  uint8_t bits = 0;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    if (self->target[row * self->stride + col / 8] & mask) 
+      bits |= 1 << row;
+    }
+  return bits;
+  }
+
+/** Copy one row of the target image into the visible part of the 
+    display. */
+static void pico7219_fx_copy_row (const struct Pico7219Fx *self, int row)
+  {
+  uint8_t *r = pico7219_get_row_buffer (self->display, row);
+  const uint8_t *t = self->target + row * self->stride;
+  if (memcmp (r, t, self->width / 8) != 0)
+    {
+    memcpy (r, t, self->width / 8);
+    pico7219_mark_row_dirty (self->display, row);
+    }
+  }
+
+/** Copy one pixel of the target image into the display. The row is 
+    marked for the next flush only if the pixel changes. */
+static void pico7219_fx_copy_pixel (const struct Pico7219Fx *self, 
+        int pixel)
+  {
+  int row = pixel / self->width;
+  int col = pixel % self->width;
+  uint8_t mask = 1 << (col % 8);
+  uint8_t *b = pico7219_get_row_buffer (self->display, row) + col / 8;
+  uint8_t v = (*b & ~mask) | 
+    (self->target[row * self->stride + col / 8] & mask);
+  if (v != *b)
+    {
+    *b = v;
+    pico7219_mark_row_dirty (self->display, row);
+    }
+  }
+
+/** Advance the wipe or dissolve by one step. */
+static void pico7219_fx_transition_step (struct Pico7219Fx *self)
+  {
+  // If the virtual chain length has changed, the target is no longer
+  //   laid out like the display, and the rows may be shorter than the
+  //   visible width, so the transition stops where it is
+  if (pico7219_get_virtual_chain_length (self->display) != self->stride)
+    {
+    self->transition = PICO7219_FX_NONE;
+    return;
+    }
+  int total = self->transition == PICO7219_FX_DISSOLVE ?
+    PICO7219_ROWS * self->width :
+    self->transition >= PICO7219_FX_WIPE_UP ? PICO7219_ROWS : self->width;
+  for (int i = 0; i < self->speed && self->done < total; i++)
+    {
+    int n = self->done++;
+    switch (self->transition)
+      {
+      case PICO7219_FX_WIPE_RIGHT:
+        pico7219_set_column (self->display, n, 
+          pico7219_fx_target_column (self, n), FALSE);
+        break;
+      case PICO7219_FX_WIPE_LEFT:
+        n = self->width - 1 - n;
+        pico7219_set_column (self->display, n, 
+          pico7219_fx_target_column (self, n), FALSE);
+        break;
+      case PICO7219_FX_WIPE_UP:
+        pico7219_fx_copy_row (self, n);
+        break;
+      case PICO7219_FX_WIPE_DOWN:
+        pico7219_fx_copy_row (self, PICO7219_ROWS - 1 - n);
+        break;
+      default:
+        pico7219_fx_copy_pixel (self, self->order[n]);
+      }
+    }
+  if (self->done == total) self->transition = PICO7219_FX_NONE;
+  }
+
+/** Advance the fade by one step. */
+static void pico7219_fx_fade_step (struct Pico7219Fx *self)
+  {
+  // The level for this tick, so the first tick gives "from"
+  int level = self->fade_from + ((int)self->fade_to - self->fade_from) * 
+    self->fade_tick / self->fade_ticks;
+  if (level != self->fade_level)
+    {
+    self->fade_level = level;
+    pico7219_set_intensity_deferred (self->display, level);
+    }
+  if (self->fade_tick == self->fade_ticks) 
+    self->fade_ticks = 0;
+  else
+    self->fade_tick++;
+  }
+
+/** pico7219_fx_tick() */
+BOOL pico7219_fx_tick (struct Pico7219Fx *self)
+  {
+  if (self->fade_ticks) pico7219_fx_fade_step (self);
+  if (self->transition != PICO7219_FX_NONE) 
+    pico7219_fx_transition_step (self);
+  return self->fade_ticks || self->transition != PICO7219_FX_NONE;
+  }
+
@@ -0,0 +1,211 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_gray.c
+
+  Grayscale rendering by temporal dithering. See pico7219_gray.h
+  for a description of how this works.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdlib.h>
+#include <string.h>
+#include "pico7219/pico7219_gray.h"
+
+struct Pico7219Gray
+  {
+  struct Pico7219 *display;
+  uint8_t depth; // Number of bit planes
+  int vchain_len; // Bytes in one row of a plane. See gray_sync()
+  // depth planes, each laid out like the library's virtual chain
+  uint8_t *planes; 
+  uint8_t plane; // The plane currently being shown
+  uint8_t ticks_left; // Ticks before the next plane is due
+  // Statistics about plane changes
+  uint32_t flushes;
+  uint64_t flush_us_total;
+  uint32_t flush_us_max;
+  };
+
+/** Get the start of a row in one plane. */
+static inline uint8_t *pico7219_gray_row (const struct Pico7219Gray *self,
+        int plane, int row)
+  {
+  return self->planes + (plane * PICO7219_ROWS + row) * self->vchain_len;
+  }
+
+/** Make the planes match the current length of the virtual chain, 
+    which the application may have changed since they were allocated;
+    otherwise a plane change would read past the end of each row. 
+    Pixels that still fit are kept. Returns FALSE if the planes can't 
+    be resized, in which case they are left unchanged, and the caller
+    should do nothing. This allocates memory, so it is called only from
+    the functions that are not called from interrupts. */
+static BOOL pico7219_gray_sync (struct Pico7219Gray *self)
+  {
+  int len = pico7219_get_virtual_chain_length (self->display);
+  if (len == self->vchain_len) return TRUE;
+  uint8_t *planes = calloc (self->depth * PICO7219_ROWS, len);
+  if (!planes) return FALSE;
+  int keep = len < self->vchain_len ? len : self->vchain_len;
+  for (int i = 0; i < self->depth * PICO7219_ROWS; i++)
+    memcpy (planes + i * len, self->planes + i * self->vchain_len, keep);
+  free (self->planes);
+  self->planes = planes;
+  self->vchain_len = len;
+  return TRUE;
+  }
+
+/** pico7219_gray_create() */
+struct Pico7219Gray *pico7219_gray_create (struct Pico7219 *display,
+        uint8_t depth)
+  {
+  if (depth < PICO7219_GRAY_MIN_DEPTH || depth > PICO7219_GRAY_MAX_DEPTH)
+    return NULL;
+  struct Pico7219Gray *self = malloc (sizeof (struct Pico7219Gray));
+  if (self)
+    {
+    self->display = display;
+    self->depth = depth;
+    self->vchain_len = pico7219_get_virtual_chain_length (display);
+    self->planes = calloc (depth * PICO7219_ROWS, self->vchain_len);
+    if (!self->planes)
+      {
+      free (self);
+      return NULL;
+      }
+    // The first tick will move on to plane 0
+    self->plane = depth - 1;
+    self->ticks_left = 0;
+    self->flushes = 0;
+    self->flush_us_total = 0;
+    self->flush_us_max = 0;
+    }
+  return self;
+  }
+
+/** pico7219_gray_destroy() */
+void pico7219_gray_destroy (struct Pico7219Gray *self)
+  {
+  if (self)
+    {
+    free (self->planes);
+    free (self);
+    }
+  }
+
+/** pico7219_gray_set_pixel() */
+void pico7219_gray_set_pixel (struct Pico7219Gray *self, uint8_t row, 
+        int col, uint8_t level)
+  {
+  if (!pico7219_gray_sync (self)) return;
+  if (row >= PICO7219_ROWS || col < 0 || col >= 8 * self->vchain_len) 
+    return;
+  int block = col / 8;
+  uint8_t v = 1 << (col % 8);
+  for (int p = 0; p < self->depth; p++)
+    {
+    uint8_t *b = pico7219_gray_row (self, p, row) + block;
+    if (level & (1 << p))
+      *b |= v;
+    else
+      *b &= ~v;
+    }
+  }
+
+/** pico7219_gray_get_pixel(). self is const, so this can't resize the
+    planes; instead, it gives the result that resizing would, 0 for any
+    pixel past the end of either the planes or the virtual chain. */
+uint8_t pico7219_gray_get_pixel (const struct Pico7219Gray *self, 
+        uint8_t row, int col)
+  {
+  if (row >= PICO7219_ROWS || col < 0 || col >= 8 * self->vchain_len ||
+      col >= 8 * pico7219_get_virtual_chain_length (self->display)) 
+    return 0;
+  int block = col / 8;
+  uint8_t v = 1 << (col % 8);
+  uint8_t level = 0;
+  for (int p = 0; p < self->depth; p++)
+    if (pico7219_gray_row (self, p, row)[block] & v) level |= 1 << p;
+  return level;
+  }
+
+/** pico7219_gray_clear() */
+void pico7219_gray_clear (struct Pico7219Gray *self)
+  {
+  if (!pico7219_gray_sync (self)) return;
+  memset (self->planes, 0, self->depth * PICO7219_ROWS * self->vchain_len);
+  }
+
+/** Copy one plane into the virtual chain and flush it. set_row() only 
+    marks rows that differ from the previous plane, so the flush sends
+    only those. */
+static void pico7219_gray_show_plane (struct Pico7219Gray *self, int plane)
+  {
+  uint64_t start = pico7219_time_us ();
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    pico7219_set_row (self->display, row, 
+      pico7219_gray_row (self, plane, row), FALSE);
+  pico7219_flush (self->display);
+  uint32_t elapsed = (uint32_t)(pico7219_time_us () - start);
+  self->flushes++;
+  self->flush_us_total += elapsed;
+  if (elapsed > self->flush_us_max) self->flush_us_max = elapsed;
+  }
+
+/** pico7219_gray_tick() */
+void pico7219_gray_tick (struct Pico7219Gray *self)
+  {
+  // This may be called from a timer interrupt, so it can't resize the
+  //   planes; until something else does, it must not read them
+  if (pico7219_get_virtual_chain_length (self->display) != self->vchain_len)
+    return;
+  if (self->ticks_left == 0)
+    {
+    self->plane = (self->plane + 1) % self->depth;
+    pico7219_gray_show_plane (self, self->plane);
+    self->ticks_left = 1 << self->plane;
+    }
+  self->ticks_left--;
+  }
+
+/** pico7219_gray_get_stats() */
+void pico7219_gray_get_stats (const struct Pico7219Gray *self, 
+        uint32_t *avg_us, uint32_t *max_us, uint32_t *max_tick_hz)
+  {
+  if (avg_us) 
+    *avg_us = self->flushes ? self->flush_us_total / self->flushes : 0;
+  if (max_us) 
+    *max_us = self->flush_us_max;
+  if (max_tick_hz)
+    *max_tick_hz = 1000000 / (self->flush_us_max ? self->flush_us_max : 1);
+  }
+
+/** pico7219_gray_estimate_levels() */
+void pico7219_gray_estimate_levels (struct Pico7219Gray *self, 
+        uint8_t *levels)
+  {
+  int width = 8 * pico7219_get_chain_length (self->display);
+  int ticks = (1 << self->depth) - 1;
+  memset (levels, 0, PICO7219_ROWS * width);
+  // Not called from an interrupt, so the planes can be resized here,
+  //   and tick will then show them
+  if (!pico7219_gray_sync (self)) return;
+  // Each tick stands for an equal time slot, in which the display 
+  //   shows whatever was last flushed. A whole frame covers every slot 
+  //   once, wherever in the frame we start.
+  for (int t = 0; t < ticks; t++)
+    {
+    pico7219_gray_tick (self);
+    for (int row = 0; row < PICO7219_ROWS; row++)
+      {
+      uint8_t bits[PICO7219_MAX_CHAIN];
+      pico7219_get_display_row (self->display, row, bits);
+      for (int col = 0; col < width; col++)
+        if (bits[col / 8] & (1 << (col % 8))) levels[row * width + col]++;
+      }
+    }
+  }
+
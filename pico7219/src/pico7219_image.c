@@ -0,0 +1,206 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_image.c
+
+  Drawing images produced by the imgc tool. See pico7219_image.h.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include "pico7219/pico7219_image.h"
+
+// Where the bytes of a frame are going
+struct Pico7219ImageTarget
+  {
+  struct Pico7219 *display;
+  uint8_t *rows[PICO7219_ROWS];
+  int vchain_len;
+  int x; 
+  int width;
+  int stride; // Bytes in each row of the frame
+  BOOL xor; // TRUE to XOR bytes into the virtual chain
+  uint8_t dirty; // One bit per row
+  };
+
+/** Store byte "index" of a frame in the virtual chain. */
+static void pico7219_image_put (struct Pico7219ImageTarget *t, int index,
+        uint8_t v)
+  {
+  int row = index / t->stride;
+  int b = index % t->stride;
+  int pos = t->x + 8 * b;
+  int n = t->width - 8 * b;
+  uint16_t mask = n >= 8 ? 0xFF : (1 << n) - 1;
+  uint16_t bits = v & mask;
+  if (pos < 0)
+    {
+    if (pos <= -8) return;
+    bits >>= -pos;
+    mask >>= -pos;
+    pos = 0;
+    }
+  bits <<= pos & 7;
+  mask <<= pos & 7;
+  uint8_t *r = t->rows[row];
+  for (int i = pos >> 3; mask && i < t->vchain_len; i++)
+    {
+    uint8_t nv = t->xor ? r[i] ^ bits : (r[i] & ~mask) | bits;
+    if (nv != r[i])
+      {
+      r[i] = nv;
+      t->dirty |= 1 << row;
+      }
+    mask >>= 8;
+    bits >>= 8;
+    }
+  }
+
+/** Set up a target for drawing a frame "width" pixels wide. */
+static void pico7219_image_target (struct Pico7219ImageTarget *t, 
+        struct Pico7219 *display, int x, int width)
+  {
+  t->display = display;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    t->rows[row] = pico7219_get_row_buffer (display, row);
+  t->vchain_len = pico7219_get_virtual_chain_length (display);
+  t->x = x;
+  t->width = width;
+  t->stride = (width + 7) / 8;
+  t->xor = FALSE;
+  t->dirty = 0;
+  }
+
+/** Mark the rows that changed for the next flush. */
+static void pico7219_image_mark_dirty (const struct Pico7219ImageTarget *t)
+  {
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    if (t->dirty & (1 << row)) pico7219_mark_row_dirty (t->display, row);
+    }
+  }
+
+/** Decode run-length encoded data into bytes index to end - 1 of a 
+    frame. Returns a pointer to the data that follows. */
+static const uint8_t *pico7219_image_unrle (struct Pico7219ImageTarget *t,
+        const uint8_t *p, int index, int end)
+  {
+  while (index < end)
+    {
+    uint8_t c = *p++;
+    if (c < 0x80)
+      {
+      for (int i = 0; i <= c && index < end; i++)
+        pico7219_image_put (t, index++, *p++);
+      }
+    else
+      {
+      uint8_t v = *p++;
+      for (int i = 0; i < c - 0x7E && index < end; i++)
+        pico7219_image_put (t, index++, v);
+      }
+    }
+  return p;
+  }
+
+/** pico7219_image_draw() */
+int pico7219_image_draw (struct Pico7219 *display, 
+       const struct Pico7219Image *image, int frame, int x, BOOL flush)
+  {
+  if (frame < 0 || frame >= image->frames) return -1;
+  struct Pico7219ImageTarget t;
+  pico7219_image_target (&t, display, x, image->width);
+  int size = PICO7219_ROWS * t.stride;
+
+  if (image->flags & PICO7219_IMAGE_RLE)
+    {
+    pico7219_image_unrle (&t, image->data + image->offsets[frame], 0, 
+      size);
+    }
+  else
+    {
+    const uint8_t *p = image->data + frame * size;
+    for (int index = 0; index < size; index++)
+      pico7219_image_put (&t, index, p[index]);
+    }
+
+  pico7219_image_mark_dirty (&t);
+  if (flush) pico7219_flush (display);
+  return image->width;
+  }
+
+/** pico7219_anim_start() */
+void pico7219_anim_start (struct Pico7219AnimPlayer *player, 
+       struct Pico7219 *display, const struct Pico7219Animation *anim, 
+       int x, BOOL loop)
+  {
+  player->display = display;
+  player->anim = anim;
+  player->x = x;
+  player->loop = loop;
+  player->playing = anim->frames > 0;
+  player->frame = 0;
+  player->next = anim->data;
+  player->due_us = pico7219_time_us ();
+  }
+
+/** Decode the next frame into the target, and advance to the one after.
+    Returns FALSE if there are no more frames. */
+static BOOL pico7219_anim_decode (struct Pico7219AnimPlayer *player,
+        struct Pico7219ImageTarget *t)
+  {
+  const struct Pico7219Animation *anim = player->anim;
+  if (player->frame == anim->frames)
+    {
+    if (!player->loop) return FALSE;
+    player->frame = 0;
+    player->next = anim->data;
+    }
+  const uint8_t *p = player->next;
+  t->xor = *p++ == PICO7219_ANIM_DELTA;
+  uint8_t rows = *p++;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    if (rows & (1 << row))
+      p = pico7219_image_unrle (t, p, row * t->stride, 
+        (row + 1) * t->stride);
+    }
+  player->next = p;
+  player->due_us += 1000 * (anim->durations ? 
+    anim->durations[player->frame] : anim->frame_ms);
+  player->frame++;
+  return TRUE;
+  }
+
+/** pico7219_anim_update() */
+BOOL pico7219_anim_update (struct Pico7219AnimPlayer *player, BOOL flush)
+  {
+  if (!player->playing) return FALSE;
+  struct Pico7219ImageTarget t;
+  pico7219_image_target (&t, player->display, player->x, 
+    player->anim->width);
+  uint64_t now = pico7219_time_us ();
+  // Catch up by at most one pass through the animation, so that frames
+  //   with no duration can't hold us here for ever
+  for (int n = 0; now >= player->due_us; n++)
+    {
+    if (n == player->anim->frames)
+      {
+      player->due_us = now + 1;
+      break;
+      }
+    if (!pico7219_anim_decode (player, &t))
+      {
+      player->playing = FALSE;
+      break;
+      }
+    }
+  if (t.dirty)
+    {
+    pico7219_image_mark_dirty (&t);
+    if (flush) pico7219_flush (player->display);
+    }
+  return player->playing;
+  }
+
@@ -0,0 +1,365 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_stream.c
+
+  Encoding and decoding of the frame stream protocol. See 
+  pico7219_stream.h for a description of the protocol.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <string.h>
+#if PICO_ON_DEVICE
+#include "pico/stdio.h"
+#include "pico/error.h"
+#else
+#include <unistd.h>
+#endif
+#include "pico7219/pico7219_stream.h"
+
+// Decoder states. Each names the thing the decoder expects next.
+enum 
+  {
+  PICO7219_STREAM_HUNT = 0, // Anything: skip to the next sync byte
+  PICO7219_STREAM_START, // The first command of a frame, or a sync byte
+  PICO7219_STREAM_COMMAND,
+  PICO7219_STREAM_KEY_WIDTH,
+  PICO7219_STREAM_ROW_ROW,
+  PICO7219_STREAM_ROW_START,
+  PICO7219_STREAM_ROW_COUNT,
+  PICO7219_STREAM_CELL_ROW,
+  PICO7219_STREAM_CELL_INDEX,
+  PICO7219_STREAM_DATA,
+  PICO7219_STREAM_CHECK1,
+  PICO7219_STREAM_CHECK2,
+  PICO7219_STREAM_SYNC_END // The sync byte that ends a frame
+  };
+
+// A run of unchanged bytes shorter than this is cheaper to send as 
+//   part of a row packet than to split the packet
+#define PICO7219_STREAM_MIN_GAP 4
+
+/** pico7219_stream_init() */
+void pico7219_stream_init (struct Pico7219StreamDecoder *dec, 
+       struct Pico7219 *display)
+  {
+  memset (dec, 0, sizeof (*dec));
+  dec->display = display;
+  dec->state = PICO7219_STREAM_HUNT;
+  dec->need_key = TRUE;
+  }
+
+/** Store one data byte directly into the display's framebuffer, marking
+    the row dirty only if the byte changes. Bytes beyond the end of the
+    virtual chain are dropped, and so are delta bytes while waiting for
+    a keyframe, and delta bytes beyond the width of the last keyframe, 
+    which a keyframe would not overwrite. */
+static void pico7219_stream_put (struct Pico7219StreamDecoder *dec, 
+        uint8_t v)
+  {
+  if (dec->row < PICO7219_ROWS && 
+      dec->index < pico7219_get_virtual_chain_length (dec->display) &&
+      (dec->key || (!dec->need_key && dec->index < dec->key_width)))
+    {
+    uint8_t *b = pico7219_get_row_buffer (dec->display, dec->row) + 
+      dec->index;
+    if (*b != v)
+      {
+      *b = v;
+      pico7219_mark_row_dirty (dec->display, dec->row);
+      }
+    }
+  dec->index++;
+  dec->remaining--;
+  // Keyframes run on from one row to the next
+  if (dec->index == dec->width && dec->remaining > 0)
+    {
+    dec->index = 0;
+    dec->row++;
+    }
+  if (dec->remaining == 0) dec->state = PICO7219_STREAM_COMMAND;
+  }
+
+/** A frame is damaged: drop it, and everything up to the next 
+    keyframe. */
+static void pico7219_stream_damaged (struct Pico7219StreamDecoder *dec)
+  {
+  dec->dropped++;
+  dec->need_key = TRUE;
+  dec->state = PICO7219_STREAM_HUNT;
+  }
+
+/** A sync byte has arrived. Returns TRUE if it completes a good frame,
+    which has been flushed. In any case, a new frame starts. */
+static BOOL pico7219_stream_sync (struct Pico7219StreamDecoder *dec)
+  {
+  BOOL shown = FALSE;
+  if (dec->state == PICO7219_STREAM_SYNC_END)
+    {
+    if (dec->key) dec->need_key = FALSE;
+    if (dec->need_key)
+      dec->dropped++;
+    else
+      {
+      pico7219_flush (dec->display);
+      dec->frames++;
+      shown = TRUE;
+      }
+    }
+  else if (dec->state != PICO7219_STREAM_HUNT && 
+           dec->state != PICO7219_STREAM_START)
+    {
+    // The frame was cut short
+    pico7219_stream_damaged (dec);
+    }
+  dec->state = PICO7219_STREAM_START;
+  dec->escaped = FALSE;
+  dec->key = FALSE;
+  dec->sum1 = 0;
+  dec->sum2 = 0;
+  return shown;
+  }
+
+/** pico7219_stream_feed() */
+int pico7219_stream_feed (struct Pico7219StreamDecoder *dec, 
+       const uint8_t *buf, int len)
+  {
+  int frames = 0;
+  dec->bytes += len;
+  for (int i = 0; i < len; i++)
+    {
+    uint8_t v = buf[i];
+    if (v == PICO7219_STREAM_SYNC)
+      {
+      if (pico7219_stream_sync (dec)) frames++;
+      continue;
+      }
+    if (dec->state == PICO7219_STREAM_HUNT) continue;
+    if (v == PICO7219_STREAM_ESC)
+      {
+      dec->escaped = TRUE;
+      continue;
+      }
+    if (dec->escaped)
+      {
+      v ^= PICO7219_STREAM_ESC_XOR;
+      dec->escaped = FALSE;
+      }
+    // The checksum covers everything before the checksum bytes
+    if (dec->state < PICO7219_STREAM_CHECK1)
+      {
+      dec->sum1 += v;
+      dec->sum2 += dec->sum1;
+      }
+    switch (dec->state)
+      {
+      case PICO7219_STREAM_START:
+      case PICO7219_STREAM_COMMAND:
+        switch (v)
+          {
+          case PICO7219_STREAM_KEY: 
+            dec->state = PICO7219_STREAM_KEY_WIDTH; 
+            break;
+          case PICO7219_STREAM_ROW: 
+            dec->state = PICO7219_STREAM_ROW_ROW; 
+            break;
+          case PICO7219_STREAM_CELL: 
+            dec->state = PICO7219_STREAM_CELL_ROW; 
+            break;
+          case PICO7219_STREAM_END: 
+            dec->state = PICO7219_STREAM_CHECK1;
+            break;
+          default: 
+            pico7219_stream_damaged (dec);
+          }
+        break;
+
+      case PICO7219_STREAM_KEY_WIDTH:
+        dec->row = 0;
+        dec->index = 0;
+        dec->width = v;
+        dec->key = TRUE;
+        dec->key_width = v;
+        dec->remaining = PICO7219_ROWS * v;
+        dec->state = v ? PICO7219_STREAM_DATA : PICO7219_STREAM_COMMAND;
+        break;
+
+      case PICO7219_STREAM_ROW_ROW:
+        dec->row = v;
+        dec->state = PICO7219_STREAM_ROW_START;
+        break;
+
+      case PICO7219_STREAM_ROW_START:
+        dec->index = v;
+        dec->state = PICO7219_STREAM_ROW_COUNT;
+        break;
+
+      case PICO7219_STREAM_ROW_COUNT:
+        dec->remaining = v;
+        dec->width = 0; // Don't run on to the next row
+        dec->state = v ? PICO7219_STREAM_DATA : PICO7219_STREAM_COMMAND;
+        break;
+
+      case PICO7219_STREAM_CELL_ROW:
+        dec->row = v;
+        dec->state = PICO7219_STREAM_CELL_INDEX;
+        break;
+
+      case PICO7219_STREAM_CELL_INDEX:
+        dec->index = v;
+        dec->remaining = 1;
+        dec->width = 0;
+        dec->state = PICO7219_STREAM_DATA;
+        break;
+
+      case PICO7219_STREAM_DATA:
+        pico7219_stream_put (dec, v);
+        break;
+
+      case PICO7219_STREAM_CHECK1:
+        dec->check1 = v;
+        dec->state = PICO7219_STREAM_CHECK2;
+        break;
+
+      case PICO7219_STREAM_CHECK2:
+        if (dec->check1 == dec->sum1 && v == dec->sum2)
+          dec->state = PICO7219_STREAM_SYNC_END;
+        else
+          pico7219_stream_damaged (dec);
+        break;
+
+      case PICO7219_STREAM_SYNC_END:
+        // Anything but a sync byte after the checksum
+        pico7219_stream_damaged (dec);
+        break;
+      }
+    }
+  return frames;
+  }
+
+/** pico7219_stream_poll_stdio() */
+int pico7219_stream_poll_stdio (struct Pico7219StreamDecoder *dec)
+  {
+  uint8_t buf[64];
+  int n = 0;
+#if PICO_ON_DEVICE
+  int c;
+  while (n < (int)sizeof (buf) && 
+         (c = getchar_timeout_us (0)) != PICO_ERROR_TIMEOUT)
+    buf[n++] = c;
+#else
+  n = read (STDIN_FILENO, buf, sizeof (buf));
+  if (n <= 0) return -1;
+#endif
+  return pico7219_stream_feed (dec, buf, n);
+  }
+
+/** pico7219_stream_get_stats() */
+void pico7219_stream_get_stats (const struct Pico7219StreamDecoder *dec, 
+       uint32_t *frames, uint32_t *bytes, uint32_t *dropped)
+  {
+  if (frames) *frames = dec->frames;
+  if (bytes) *bytes = dec->bytes;
+  if (dropped) *dropped = dec->dropped;
+  }
+
+// The encoder's output. Bytes are checksummed and escaped as they are
+//   written.
+struct Pico7219StreamWriter
+  {
+  uint8_t *out;
+  int len;
+  uint8_t sum1, sum2;
+  };
+
+/** Write one byte of a frame, escaping it if necessary. */
+static void pico7219_stream_write (struct Pico7219StreamWriter *w, 
+        uint8_t v)
+  {
+  w->sum1 += v;
+  w->sum2 += w->sum1;
+  if (v == PICO7219_STREAM_SYNC || v == PICO7219_STREAM_ESC)
+    {
+    w->out[w->len++] = PICO7219_STREAM_ESC;
+    v ^= PICO7219_STREAM_ESC_XOR;
+    }
+  w->out[w->len++] = v;
+  }
+
+/** Write the delta packets that turn prev into cur, or, if w is NULL,
+    just work out their size. Returns the size of the packets before
+    escaping. */
+static int pico7219_stream_delta (const uint8_t *prev, const uint8_t *cur,
+        int width, struct Pico7219StreamWriter *w)
+  {
+  int n = 0;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    const uint8_t *p = prev + row * width;
+    const uint8_t *c = cur + row * width;
+    int i = 0;
+    while (i < width)
+      {
+      if (p[i] == c[i]) { i++; continue; }
+      // Extend the run of changes until there is a long enough gap
+      int start = i, end = i + 1, gap = 0;
+      for (int j = end; j < width && gap < PICO7219_STREAM_MIN_GAP; j++)
+        {
+        if (p[j] != c[j]) 
+          {
+          end = j + 1;
+          gap = 0;
+          }
+        else
+          gap++;
+        }
+      int len = end - start;
+      n += len == 1 ? 4 : 4 + len;
+      if (w && len == 1)
+        {
+        pico7219_stream_write (w, PICO7219_STREAM_CELL);
+        pico7219_stream_write (w, row);
+        pico7219_stream_write (w, start);
+        pico7219_stream_write (w, c[start]);
+        }
+      else if (w)
+        {
+        pico7219_stream_write (w, PICO7219_STREAM_ROW);
+        pico7219_stream_write (w, row);
+        pico7219_stream_write (w, start);
+        pico7219_stream_write (w, len);
+        for (int k = start; k < end; k++)
+          pico7219_stream_write (w, c[k]);
+        }
+      i = end;
+      }
+    }
+  return n;
+  }
+
+/** pico7219_stream_encode() */
+int pico7219_stream_encode (const uint8_t *prev, const uint8_t *cur, 
+       int width, uint8_t *out)
+  {
+  struct Pico7219StreamWriter w = { out, 0, 0, 0 };
+  out[w.len++] = PICO7219_STREAM_SYNC;
+  // A delta is used only if it is smaller than a keyframe
+  if (prev && pico7219_stream_delta (prev, cur, width, NULL) < 
+        2 + PICO7219_ROWS * width)
+    pico7219_stream_delta (prev, cur, width, &w);
+  else
+    {
+    pico7219_stream_write (&w, PICO7219_STREAM_KEY);
+    pico7219_stream_write (&w, width);
+    for (int i = 0; i < PICO7219_ROWS * width; i++)
+      pico7219_stream_write (&w, cur[i]);
+    }
+  pico7219_stream_write (&w, PICO7219_STREAM_END);
+  uint8_t sum1 = w.sum1, sum2 = w.sum2;
+  pico7219_stream_write (&w, sum1);
+  pico7219_stream_write (&w, sum2);
+  out[w.len++] = PICO7219_STREAM_SYNC;
+  return w.len;
+  }
@@ -0,0 +1,158 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  pico7219_trace.c
+
+  The event trace ring. See pico7219_trace.h. Nothing here is built
+  unless PICO7219_TRACE is defined.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include "pico7219/pico7219_trace.h"
+
+#ifdef PICO7219_TRACE
+
+#include <stdio.h>
+#if PICO_ON_DEVICE
+#include "pico/platform.h"
+#include "hardware/sync.h"
+#endif
+#include "pico7219/pico7219.h"
+
+#if PICO_ON_DEVICE
+#define PICO7219_TRACE_CORES 2
+#else
+#define PICO7219_TRACE_CORES 1
+#endif
+
+// One recorded event. seq is the number of the event in its core's
+//   ring, counting from the start, and is written last, so a reader
+//   can tell whether a slot holds the event it expects.
+struct Pico7219TraceEntry
+  {
+  uint32_t time_us;
+  int16_t value;
+  uint8_t event;
+  uint8_t phase_core; // Phase character in bits 0-6, core in bit 7
+  uint32_t seq;
+  };
+
+// The events recorded on one core. Only that core writes head, so
+//   claiming a slot needs no atomic read-modify-write, which the
+//   RP2040's Cortex-M0+ cores don't have.
+struct Pico7219TraceRing
+  {
+  struct Pico7219TraceEntry entries[PICO7219_TRACE_SIZE];
+  uint32_t head; // Number of events ever claimed
+  uint32_t start; // Events before this one are not dumped
+  };
+
+static struct Pico7219TraceRing pico7219_trace_rings[PICO7219_TRACE_CORES];
+
+static const char *const pico7219_trace_names[PICO7219_TRACE_EVENTS] =
+  {
+  "flush", "row", "scroll", "cs", "init"
+  };
+
+static const char *const pico7219_trace_values[PICO7219_TRACE_EVENTS] =
+  {
+  "rows", "row", "dx", "level", "modules"
+  };
+
+/** Claim the next slot in a ring. On the Pico, only the ring's own 
+    core gets here, but an interrupt handler on that core could claim
+    a slot between the load and the store of head, so interrupts are
+    masked for those two instructions. The other core is never held
+    up. The host has no interrupts, but may have several threads. */
+static uint32_t pico7219_trace_claim (struct Pico7219TraceRing *ring)
+  {
+#if PICO_ON_DEVICE
+  uint32_t save = save_and_disable_interrupts ();
+  uint32_t seq = ring->head;
+  __atomic_store_n (&ring->head, seq + 1, __ATOMIC_RELAXED);
+  restore_interrupts (save);
+  return seq;
+#else
+  return __atomic_fetch_add (&ring->head, 1, __ATOMIC_RELAXED);
+#endif
+  }
+
+/** pico7219_trace_record() */
+void pico7219_trace_record (enum Pico7219TraceEvent event, char phase, 
+       int value)
+  {
+#if PICO_ON_DEVICE
+  uint8_t core = get_core_num ();
+#else
+  uint8_t core = 0;
+#endif
+  struct Pico7219TraceRing *ring = &pico7219_trace_rings[core];
+  uint32_t seq = pico7219_trace_claim (ring);
+  struct Pico7219TraceEntry *e = 
+    &ring->entries[seq & (PICO7219_TRACE_SIZE - 1)];
+  // Mark the slot as being written, so a dump in progress skips it
+  __atomic_store_n (&e->seq, seq - 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_RELEASE);
+  e->time_us = (uint32_t)pico7219_time_us ();
+  e->value = value;
+  e->event = event;
+  e->phase_core = phase | core << 7;
+  __atomic_store_n (&e->seq, seq, __ATOMIC_RELEASE);
+  }
+
+/** pico7219_trace_clear() */
+void pico7219_trace_clear (void)
+  {
+  for (int i = 0; i < PICO7219_TRACE_CORES; i++)
+    {
+    struct Pico7219TraceRing *ring = &pico7219_trace_rings[i];
+    ring->start = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+    }
+  }
+
+/** Write the events of one ring, oldest first. Returns TRUE if any
+    have been written, including those written before. */
+static BOOL pico7219_trace_dump_ring (const struct Pico7219TraceRing *ring,
+        BOOL comma)
+  {
+  uint32_t head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+  uint32_t first = head - ring->start > PICO7219_TRACE_SIZE ?
+    head - PICO7219_TRACE_SIZE : ring->start;
+  for (uint32_t seq = first; seq != head; seq++)
+    {
+    const struct Pico7219TraceEntry *e = 
+      &ring->entries[seq & (PICO7219_TRACE_SIZE - 1)];
+    if (__atomic_load_n (&e->seq, __ATOMIC_ACQUIRE) != seq) continue;
+    struct Pico7219TraceEntry copy = *e;
+    // Skip the event if it was overwritten while we copied it
+    __atomic_thread_fence (__ATOMIC_ACQUIRE);
+    if (__atomic_load_n (&e->seq, __ATOMIC_RELAXED) != seq) continue;
+    if (copy.event >= PICO7219_TRACE_EVENTS) continue;
+    char phase = copy.phase_core & 0x7F;
+    printf ("%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":0,"
+      "\"tid\":%d,%s\"args\":{\"%s\":%d}}", comma ? ",\n" : "", 
+      pico7219_trace_names[copy.event], phase, 
+      (unsigned long)copy.time_us, copy.phase_core >> 7, 
+      phase == 'i' ? "\"s\":\"t\"," : "", 
+      pico7219_trace_values[copy.event], copy.value);
+    comma = TRUE;
+    }
+  return comma;
+  }
+
+/** pico7219_trace_dump() */
+void pico7219_trace_dump (void)
+  {
+  BOOL comma = FALSE;
+  printf ("{\"traceEvents\":[\n");
+  // The viewers sort events by time, so each core's can be written in
+  //   turn
+  for (int i = 0; i < PICO7219_TRACE_CORES; i++)
+    comma = pico7219_trace_dump_ring (&pico7219_trace_rings[i], comma);
+  printf ("\n],\"displayTimeUnit\":\"ms\"}\n");
+  }
+
+#endif
+
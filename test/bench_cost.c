@@ -0,0 +1,113 @@
+/*=========================================================================
+
+  Pico7219
+
+  bench_cost.c
+
+  Compares the cost model in pico7219_cost.h with what a flush really
+  does, using pico7219_cost_measure_flush(), on the host. For each
+  number of changed rows, with and without background refresh and a
+  current limit, the SPI traffic that the host build prints is
+  counted, and must agree with the bytes and chip-select cycles that
+  pico7219_cost_flush() predicts: exactly, except that a current limit
+  is modelled as the worst case, so may need fewer. The measured time
+  is reported beside the modelled time. On the host it includes
+  printing the traffic, so it is not comparable with the model's
+  RP2040 figures, but the same comparison built for the Pico is.
+
+  The traffic is written to a temporary file, and the results to
+  stderr.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pico7219/pico7219.h>
+#include <pico7219/pico7219_cost.h>
+
+#define CHAIN_LEN 4
+#define CS 17
+#define BAUD 1000000
+#define COUNT 100
+
+/** Count the SPI words and chip-select cycles written to the file
+    since offset. */
+static void count_traffic (const char *path, long offset, long *words,
+        long *cycles)
+  {
+  *words = 0;
+  *cycles = 0;
+  FILE *f = fopen (path, "r");
+  if (!f) return;
+  fseek (f, offset, SEEK_SET);
+  char line[100];
+  int pin, level;
+  while (fgets (line, sizeof (line), f))
+    {
+    if (strncmp (line, "SPI write", 9) == 0)
+      (*words)++;
+    else if (sscanf (line, "Set GPIO %d = %d", &pin, &level) == 2 &&
+             pin == CS && level)
+      (*cycles)++;
+    }
+  fclose (f);
+  }
+
+int main (void)
+  {
+  char path[] = "/tmp/bench_costXXXXXX";
+  int fd = mkstemp (path);
+  if (fd < 0) return 1;
+  close (fd);
+  if (!freopen (path, "w", stdout)) return 1;
+
+  struct Pico7219 *display = pico7219_create (PICO_SPI_0, BAUD, 19, 18,
+    CS, CHAIN_LEN, FALSE);
+  if (!display) return 1;
+  // Something lit, so that a current limit has something to limit
+  pico7219_fill_rect (display, 0, 0, 20, 8, TRUE, TRUE);
+  pico7219_set_intensity (display, 15);
+
+  int errors = 0;
+  fprintf (stderr, "rows refresh limit   bytes  cycles   model us  "
+    "measured us\n");
+  for (int config = 0; config < 3; config++)
+    {
+    BOOL refresh = config == 1;
+    BOOL limit = config == 2;
+    pico7219_set_refresh (display, refresh);
+    pico7219_set_current_limit (display, limit ? 40 : 0, FALSE);
+    for (int rows = 0; rows <= PICO7219_ROWS; rows++)
+      {
+      struct Pico7219CostParams params =
+        { CHAIN_LEN, CHAIN_LEN, BAUD, FALSE, rows, refresh, limit };
+      struct Pico7219CostEstimate estimate;
+      pico7219_cost_flush (&params, &estimate);
+
+      fflush (stdout);
+      long offset = ftell (stdout);
+      uint32_t us = pico7219_cost_measure_flush (display, rows, COUNT);
+      fflush (stdout);
+      long words, cycles;
+      count_traffic (path, offset, &words, &cycles);
+
+      long bytes = 2 * words / COUNT;
+      cycles /= COUNT;
+      BOOL ok = limit ? bytes <= (long)estimate.bytes &&
+                        cycles <= (long)estimate.cs_cycles
+                      : bytes == (long)estimate.bytes &&
+                        cycles == (long)estimate.cs_cycles;
+      fprintf (stderr, "%4d %7s %5s %4ld/%-4u %3ld/%-3u %8u %10u%s\n",
+        rows, refresh ? "yes" : "no", limit ? "yes" : "no", bytes,
+        estimate.bytes, cycles, estimate.cs_cycles, estimate.total_us,
+        us, ok ? "" : "  WRONG");
+      if (!ok) errors++;
+      }
+    }
+  pico7219_destroy (display, FALSE);
+  remove (path);
+  return errors != 0;
+  }
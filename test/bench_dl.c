@@ -0,0 +1,151 @@
+/*=========================================================================
+
+  Pico7219
+
+  bench_dl.c
+
+  Checks and times display list replay, on the host. A list of pixel
+  changes, some beyond column 255 of a long virtual chain and some
+  outside it altogether, is replayed, and the virtual chain compared
+  with the pixels expected. Then a scene of pixels and rectangles is
+  drawn repeatedly, once by replaying a list, and once by calling the
+  drawing functions directly; both flush once, at the end, so the
+  times compare the cost of recording and decoding the list with 
+  calling the functions. Returns a non-zero status if the pixels are
+  wrong.
+
+  The host build of the library prints its SPI traffic, so stdout is
+  discarded while timing, and the results are written to stderr.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include <pico7219/pico7219.h>
+#include <pico7219/pico7219_dl.h>
+
+#define CHAIN_LEN 4
+#define VIRTUAL_LEN 40
+#define WIDTH (PICO7219_COLS * VIRTUAL_LEN)
+#define PIXELS 1000
+#define SCENE_PIXELS 64
+#define SCENE_RECTS 8
+#define REPEATS 200
+
+static uint8_t list_buf[8192];
+static uint8_t expected[PICO7219_ROWS][WIDTH];
+
+static uint32_t seed = 1;
+
+/** A pseudo-random number from 0 to n - 1. */
+static int next (int n)
+  {
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 8) % n;
+  }
+
+/** Draw the benchmark scene directly, with one flush at the end. */
+static void draw_direct (struct Pico7219 *display)
+  {
+  seed = 99;
+  pico7219_switch_off_all (display, FALSE);
+  for (int i = 0; i < SCENE_PIXELS; i++)
+    {
+    int x = next (WIDTH);
+    pico7219_set_pixel (display, next (PICO7219_ROWS), x, TRUE, FALSE);
+    }
+  for (int i = 0; i < SCENE_RECTS; i++)
+    {
+    int x = next (WIDTH), y = next (PICO7219_ROWS);
+    int w = 1 + next (16), h = 1 + next (4);
+    pico7219_fill_rect (display, x, y, w, h, TRUE, FALSE);
+    }
+  pico7219_flush (display);
+  }
+
+/** Record the same scene as draw_direct() in a display list. */
+static void record_scene (struct Pico7219DisplayList *dl)
+  {
+  seed = 99;
+  pico7219_dl_reset (dl);
+  pico7219_dl_clear (dl);
+  for (int i = 0; i < SCENE_PIXELS; i++)
+    {
+    int x = next (WIDTH);
+    pico7219_dl_pixel (dl, x, next (PICO7219_ROWS), TRUE);
+    }
+  for (int i = 0; i < SCENE_RECTS; i++)
+    {
+    int x = next (WIDTH), y = next (PICO7219_ROWS);
+    int w = 1 + next (16), h = 1 + next (4);
+    pico7219_dl_rect (dl, x, y, w, h, TRUE);
+    }
+  }
+
+int main (void)
+  {
+  struct Pico7219 *a = pico7219_create (PICO_SPI_0, 1000000, 19, 18, 17,
+    CHAIN_LEN, FALSE);
+  struct Pico7219 *b = pico7219_create (PICO_SPI_0, 1000000, 19, 18, 16,
+    CHAIN_LEN, FALSE);
+  if (!a || !b || !pico7219_set_virtual_chain_length (a, VIRTUAL_LEN) ||
+      !pico7219_set_virtual_chain_length (b, VIRTUAL_LEN))
+    return 1;
+
+  // Pixels, checked against a plain array
+  struct Pico7219DisplayList dl;
+  pico7219_dl_init (&dl, list_buf, sizeof (list_buf));
+  pico7219_dl_clear (&dl);
+  for (int i = 0; i < PIXELS; i++)
+    {
+    int x = next (WIDTH + 64) - 32;
+    int y = next (PICO7219_ROWS);
+    BOOL on = next (4) != 0;
+    pico7219_dl_pixel (&dl, x, y, on);
+    if (x >= 0 && x < WIDTH) expected[y][x] = on;
+    }
+  if (dl.overflow || !pico7219_dl_replay (a, dl.buf, dl.len, NULL, FALSE))
+    return 1;
+  int errors = 0;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    const uint8_t *data = pico7219_get_row_buffer (a, row);
+    for (int col = 0; col < WIDTH; col++)
+      if (((data[col / 8] >> (col % 8)) & 1) != expected[row][col])
+        errors++;
+    }
+  fprintf (stderr, "Replayed %d pixels, %d wrong\n", PIXELS, errors);
+  if (errors) return 1;
+
+  // The scene, both ways, which must give the same pixels
+  record_scene (&dl);
+  if (!freopen ("/dev/null", "w", stdout)) return 1;
+  uint64_t start = pico7219_time_us ();
+  for (int i = 0; i < REPEATS; i++)
+    pico7219_dl_replay (a, dl.buf, dl.len, NULL, TRUE);
+  uint64_t replay_us = pico7219_time_us () - start;
+  start = pico7219_time_us ();
+  for (int i = 0; i < REPEATS; i++)
+    draw_direct (b);
+  uint64_t direct_us = pico7219_time_us () - start;
+
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    if (memcmp (pico7219_get_row_buffer (a, row),
+          pico7219_get_row_buffer (b, row), VIRTUAL_LEN))
+      {
+      fprintf (stderr, "Replay and direct drawing differ\n");
+      return 1;
+      }
+
+  fprintf (stderr, "Scene of %d operations, in a %d byte list:\n",
+    1 + SCENE_PIXELS + SCENE_RECTS, dl.len);
+  fprintf (stderr, "  Replay, one flush       %8.1f us\n",
+    (double)replay_us / REPEATS);
+  fprintf (stderr, "  Direct, one flush       %8.1f us\n",
+    (double)direct_us / REPEATS);
+  pico7219_destroy (a, FALSE);
+  pico7219_destroy (b, FALSE);
+  return 0;
+  }
+
@@ -0,0 +1,110 @@
+/*=========================================================================
+
+  Pico7219
+
+  bench_hpp.cpp
+
+  Compares scrolling with the C++ wrapper, whose geometry is fixed at
+  compile time, with scrolling through the C API, on the host. First
+  it checks that the two give exactly the same pixels and blink
+  attributes, with the rows rotated by a vertical move; then it times
+  each, without writing to the hardware, and reports the time for one
+  pixel of scroll. Returns a non-zero status if the results differ.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <cstdio>
+#include <cstring>
+#include <pico7219/pico7219.hpp>
+
+#define CHAIN_LEN 4
+#define VIRTUAL_LEN 16
+#define CHECK_STEPS 300
+#define BENCH_STEPS 200000
+
+using Display = pico7219::Display<CHAIN_LEN, VIRTUAL_LEN>;
+
+// Global, because the object holds its own storage
+static Display display (PICO_SPI_0, 1000000, 19, 18, 17);
+
+/** Compare the pixels and blink attributes of the two displays. */
+static bool same (Pico7219 *a, Pico7219 *b)
+  {
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    if (memcmp (pico7219_get_row_buffer (a, row),
+          pico7219_get_row_buffer (b, row), VIRTUAL_LEN))
+      return false;
+    const uint8_t *ba = pico7219_get_blink_row_buffer (a, row);
+    const uint8_t *bb = pico7219_get_blink_row_buffer (b, row);
+    if (!ba != !bb || (ba && memcmp (ba, bb, VIRTUAL_LEN)))
+      return false;
+    }
+  return true;
+  }
+
+int main ()
+  {
+  Pico7219 *c = pico7219_create (PICO_SPI_0, 1000000, 19, 18, 16,
+    CHAIN_LEN, FALSE);
+  if (!display.ok () || !c ||
+      !pico7219_set_virtual_chain_length (c, VIRTUAL_LEN))
+    return 1;
+
+  // The same pattern and blink attributes on both
+  uint32_t seed = 1;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    for (int col = 0; col < PICO7219_COLS * VIRTUAL_LEN; col++)
+      {
+      seed = seed * 1103515245 + 12345;
+      BOOL on = (seed >> 16) & 1;
+      display.set (row, col, on);
+      if (on) pico7219_switch_on (c, row, col, FALSE);
+      }
+    }
+  pico7219_set_blink_rect (display.get (), 5, 2, 20, 3, TRUE);
+  pico7219_set_blink_rect (c, 5, 2, 20, 3, TRUE);
+  pico7219_move (display.get (), 0, 3, TRUE);
+  pico7219_move (c, 0, 3, TRUE);
+
+  for (int i = 0; i < CHECK_STEPS; i++)
+    {
+    bool wrap = i < CHECK_STEPS / 2;
+    display.shift_left (wrap);
+    pico7219_move (c, 1, 0, wrap);
+    if (!same (display.get (), c))
+      {
+      printf ("C++ and C results differ after %d steps\n", i + 1);
+      return 1;
+      }
+    }
+
+  uint64_t start = pico7219_time_us ();
+  for (int i = 0; i < BENCH_STEPS; i++)
+    display.shift_left (true);
+  uint64_t hpp_us = pico7219_time_us () - start;
+
+  start = pico7219_time_us ();
+  for (int i = 0; i < BENCH_STEPS; i++)
+    pico7219_move (c, 1, 0, TRUE);
+  uint64_t c_us = pico7219_time_us () - start;
+
+  // Both have scrolled all the way round the same number of times
+  if (!same (display.get (), c))
+    {
+    printf ("C++ and C results differ after the benchmark\n");
+    return 1;
+    }
+
+  printf ("%d x %d modules, one pixel of scroll:\n", CHAIN_LEN, VIRTUAL_LEN);
+  printf ("  C++ Display::shift_left()  %6.1f ns\n",
+    1000.0 * hpp_us / BENCH_STEPS);
+  printf ("  C pico7219_move()          %6.1f ns\n",
+    1000.0 * c_us / BENCH_STEPS);
+  if (hpp_us) printf ("  Speed-up %.2fx\n", (double)c_us / hpp_us);
+  pico7219_destroy (c, FALSE);
+  return 0;
+  }
+
@@ -0,0 +1,627 @@
+/*==========================================================================
+ 
+  Pico7219
+
+  font8_ext.c
+  
+  Glyphs beyond ASCII, to go with font8.c: some accented Latin letters,
+  symbols, and the Cyrillic capitals. Each glyph is its Unicode code 
+  point followed by eight rows, in the same layout as font8.c. Cyrillic
+  letters that look like Latin ones are copies of the Latin glyphs.
+
+  This table is not linked into the program. It is read by the fontc
+  tool at build time, which merges it into the packed font.
+
+==========================================================================*/
+
+#include <stdint.h>
+
+const uint16_t font8_ext_table[] = 
+{
+	// U+00A3 '£'
+	0x00A3,
+	0x30, //   ## 
+	0x40, //  #   
+	0xE0, // ###  
+	0x40, //  #   
+	0x48, //  #  #
+	0xF8, // #####
+	0x00, //      
+	0x00, //      
+
+	// U+00B0 '°'
+	0x00B0,
+	0x60, //  ##  
+	0x90, // #  # 
+	0x60, //  ##  
+	0x00, //      
+	0x00, //      
+	0x00, //      
+	0x00, //      
+	0x00, //      
+
+	// U+00C4 'Ä'
+	0x00C4,
+	0x50, //  # # 
+	0x20, //   #  
+	0x50, //  # # 
+	0x70, //  ### 
+	0x88, // #   #
+	0xD8, // ## ##
+	0x00, //      
+	0x00, //      
+
+	// U+00D6 'Ö'
+	0x00D6,
+	0x50, //  # # 
+	0x30, //   ## 
+	0x48, //  #  #
+	0x48, //  #  #
+	0x48, //  #  #
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00DC 'Ü'
+	0x00DC,
+	0x50, //  # # 
+	0x48, //  #  #
+	0x48, //  #  #
+	0x48, //  #  #
+	0x48, //  #  #
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00DF 'ß'
+	0x00DF,
+	0x60, //  ##  
+	0x90, // #  # 
+	0xA0, // # #  
+	0x90, // #  # 
+	0x90, // #  # 
+	0xB0, // # ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00E0 'à'
+	0x00E0,
+	0x40, //  #   
+	0x20, //   #  
+	0x30, //   ## 
+	0x10, //    # 
+	0x70, //  ### 
+	0x78, //  ####
+	0x00, //      
+	0x00, //      
+
+	// U+00E1 'á'
+	0x00E1,
+	0x10, //    # 
+	0x20, //   #  
+	0x30, //   ## 
+	0x10, //    # 
+	0x70, //  ### 
+	0x78, //  ####
+	0x00, //      
+	0x00, //      
+
+	// U+00E2 'â'
+	0x00E2,
+	0x20, //   #  
+	0x50, //  # # 
+	0x30, //   ## 
+	0x10, //    # 
+	0x70, //  ### 
+	0x78, //  ####
+	0x00, //      
+	0x00, //      
+
+	// U+00E4 'ä'
+	0x00E4,
+	0x50, //  # # 
+	0x00, //      
+	0x30, //   ## 
+	0x10, //    # 
+	0x70, //  ### 
+	0x78, //  ####
+	0x00, //      
+	0x00, //      
+
+	// U+00E7 'ç'
+	0x00E7,
+	0x00, //      
+	0x00, //      
+	0x70, //  ### 
+	0x40, //  #   
+	0x40, //  #   
+	0x70, //  ### 
+	0x20, //   #  
+	0x60, //  ##  
+
+	// U+00E8 'è'
+	0x00E8,
+	0x40, //  #   
+	0x20, //   #  
+	0x70, //  ### 
+	0x70, //  ### 
+	0x40, //  #   
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00E9 'é'
+	0x00E9,
+	0x10, //    # 
+	0x20, //   #  
+	0x70, //  ### 
+	0x70, //  ### 
+	0x40, //  #   
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00EA 'ê'
+	0x00EA,
+	0x20, //   #  
+	0x50, //  # # 
+	0x70, //  ### 
+	0x70, //  ### 
+	0x40, //  #   
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00EB 'ë'
+	0x00EB,
+	0x50, //  # # 
+	0x00, //      
+	0x70, //  ### 
+	0x70, //  ### 
+	0x40, //  #   
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00EF 'ï'
+	0x00EF,
+	0x50, //  # # 
+	0x00, //      
+	0x60, //  ##  
+	0x20, //   #  
+	0x20, //   #  
+	0x70, //  ### 
+	0x00, //      
+	0x00, //      
+
+	// U+00F1 'ñ'
+	0x00F1,
+	0x68, //  ## #
+	0xB0, // # ## 
+	0xF0, // #### 
+	0x48, //  #  #
+	0x48, //  #  #
+	0xC8, // ##  #
+	0x00, //      
+	0x00, //      
+
+	// U+00F3 'ó'
+	0x00F3,
+	0x10, //    # 
+	0x20, //   #  
+	0x30, //   ## 
+	0x48, //  #  #
+	0x48, //  #  #
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00F6 'ö'
+	0x00F6,
+	0x50, //  # # 
+	0x00, //      
+	0x30, //   ## 
+	0x48, //  #  #
+	0x48, //  #  #
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+00FA 'ú'
+	0x00FA,
+	0x10, //    # 
+	0x20, //   #  
+	0xD8, // ## ##
+	0x48, //  #  #
+	0x48, //  #  #
+	0x38, //   ###
+	0x00, //      
+	0x00, //      
+
+	// U+00FC 'ü'
+	0x00FC,
+	0x50, //  # # 
+	0x00, //      
+	0xD8, // ## ##
+	0x48, //  #  #
+	0x48, //  #  #
+	0x38, //   ###
+	0x00, //      
+	0x00, //      
+
+	// U+0401 'Ё'
+	0x0401,
+	0x50, //  # # 
+	0xF8, // #####
+	0x80, // #    
+	0xF0, // #### 
+	0x80, // #    
+	0xF8, // #####
+	0x00, //      
+	0x00, //      
+
+	// U+0410 'А'
+	0x0410,
+	0x60, //  ##  
+	0x20, //   #  
+	0x50, //  # # 
+	0x70, //  ### 
+	0x88, // #   #
+	0xD8, // ## ##
+	0x00, //      
+	0x00, //      
+
+	// U+0411 'Б'
+	0x0411,
+	0xF8, // #####
+	0x80, // #    
+	0xF0, // #### 
+	0x88, // #   #
+	0x88, // #   #
+	0xF0, // #### 
+	0x00, //      
+	0x00, //      
+
+	// U+0412 'В'
+	0x0412,
+	0xF0, // #### 
+	0x48, //  #  #
+	0x70, //  ### 
+	0x48, //  #  #
+	0x48, //  #  #
+	0xF0, // #### 
+	0x00, //      
+	0x00, //      
+
+	// U+0413 'Г'
+	0x0413,
+	0xF8, // #####
+	0x80, // #    
+	0x80, // #    
+	0x80, // #    
+	0x80, // #    
+	0x80, // #    
+	0x00, //      
+	0x00, //      
+
+	// U+0414 'Д'
+	0x0414,
+	0x30, //   ## 
+	0x50, //  # # 
+	0x50, //  # # 
+	0x50, //  # # 
+	0xF8, // #####
+	0x88, // #   #
+	0x00, //      
+	0x00, //      
+
+	// U+0415 'Е'
+	0x0415,
+	0xF8, // #####
+	0x48, //  #  #
+	0x60, //  ##  
+	0x40, //  #   
+	0x48, //  #  #
+	0xF8, // #####
+	0x00, //      
+	0x00, //      
+
+	// U+0416 'Ж'
+	0x0416,
+	0xA8, // # # #
+	0xA8, // # # #
+	0x70, //  ### 
+	0x70, //  ### 
+	0xA8, // # # #
+	0xA8, // # # #
+	0x00, //      
+	0x00, //      
+
+	// U+0417 'З'
+	0x0417,
+	0x70, //  ### 
+	0x88, // #   #
+	0x30, //   ## 
+	0x08, //     #
+	0x88, // #   #
+	0x70, //  ### 
+	0x00, //      
+	0x00, //      
+
+	// U+0418 'И'
+	0x0418,
+	0x88, // #   #
+	0x98, // #  ##
+	0xA8, // # # #
+	0xA8, // # # #
+	0xC8, // ##  #
+	0x88, // #   #
+	0x00, //      
+	0x00, //      
+
+	// U+0419 'Й'
+	0x0419,
+	0x50, //  # # 
+	0x88, // #   #
+	0x98, // #  ##
+	0xA8, // # # #
+	0xC8, // ##  #
+	0x88, // #   #
+	0x00, //      
+	0x00, //      
+
+	// U+041A 'К'
+	0x041A,
+	0xD8, // ## ##
+	0x50, //  # # 
+	0x60, //  ##  
+	0x70, //  ### 
+	0x50, //  # # 
+	0xD8, // ## ##
+	0x00, //      
+	0x00, //      
+
+	// U+041B 'Л'
+	0x041B,
+	0x38, //   ###
+	0x48, //  #  #
+	0x48, //  #  #
+	0x48, //  #  #
+	0x48, //  #  #
+	0x88, // #   #
+	0x00, //      
+	0x00, //      
+
+	// U+041C 'М'
+	0x041C,
+	0xD8, // ## ##
+	0xD8, // ## ##
+	0xD8, // ## ##
+	0xA8, // # # #
+	0x88, // #   #
+	0xD8, // ## ##
+	0x00, //      
+	0x00, //      
+
+	// U+041D 'Н'
+	0x041D,
+	0xE8, // ### #
+	0x48, //  #  #
+	0x78, //  ####
+	0x48, //  #  #
+	0x48, //  #  #
+	0xE8, // ### #
+	0x00, //      
+	0x00, //      
+
+	// U+041E 'О'
+	0x041E,
+	0x30, //   ## 
+	0x48, //  #  #
+	0x48, //  #  #
+	0x48, //  #  #
+	0x48, //  #  #
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+041F 'П'
+	0x041F,
+	0xF8, // #####
+	0x88, // #   #
+	0x88, // #   #
+	0x88, // #   #
+	0x88, // #   #
+	0x88, // #   #
+	0x00, //      
+	0x00, //      
+
+	// U+0420 'Р'
+	0x0420,
+	0xF0, // #### 
+	0x48, //  #  #
+	0x48, //  #  #
+	0x70, //  ### 
+	0x40, //  #   
+	0xE0, // ###  
+	0x00, //      
+	0x00, //      
+
+	// U+0421 'С'
+	0x0421,
+	0x70, //  ### 
+	0x50, //  # # 
+	0x40, //  #   
+	0x40, //  #   
+	0x40, //  #   
+	0x30, //   ## 
+	0x00, //      
+	0x00, //      
+
+	// U+0422 'Т'
+	0x0422,
+	0xF8, // #####
+	0xA8, // # # #
+	0x20, //   #  
+	0x20, //   #  
+	0x20, //   #  
+	0x70, //  ### 
+	0x00, //      
+	0x00, //      
+
+	// U+0423 'У'
+	0x0423,
+	0x88, // #   #
+	0x88, // #   #
+	0x50, //  # # 
+	0x20, //   #  
+	0x40, //  #   
+	0x80, // #    
+	0x00, //      
+	0x00, //      
+
+	// U+0424 'Ф'
+	0x0424,
+	0x20, //   #  
+	0x70, //  ### 
+	0xA8, // # # #
+	0xA8, // # # #
+	0x70, //  ### 
+	0x20, //   #  
+	0x00, //      
+	0x00, //      
+
+	// U+0425 'Х'
+	0x0425,
+	0xD8, // ## ##
+	0x50, //  # # 
+	0x20, //   #  
+	0x20, //   #  
+	0x50, //  # # 
+	0xD8, // ## ##
+	0x00, //      
+	0x00, //      
+
+	// U+0426 'Ц'
+	0x0426,
+	0x90, // #  # 
+	0x90, // #  # 
+	0x90, // #  # 
+	0x90, // #  # 
+	0xF8, // #####
+	0x08, //     #
+	0x00, //      
+	0x00, //      
+
+	// U+0427 'Ч'
+	0x0427,
+	0x88, // #   #
+	0x88, // #   #
+	0x88, // #   #
+	0x78, //  ####
+	0x08, //     #
+	0x08, //     #
+	0x00, //      
+	0x00, //      
+
+	// U+0428 'Ш'
+	0x0428,
+	0xA8, // # # #
+	0xA8, // # # #
+	0xA8, // # # #
+	0xA8, // # # #
+	0xA8, // # # #
+	0xF8, // #####
+	0x00, //      
+	0x00, //      
+
+	// U+0429 'Щ'
+	0x0429,
+	0xA8, // # # #
+	0xA8, // # # #
+	0xA8, // # # #
+	0xA8, // # # #
+	0xF8, // #####
+	0x08, //     #
+	0x00, //      
+	0x00, //      
+
+	// U+042A 'Ъ'
+	0x042A,
+	0xC0, // ##   
+	0x40, //  #   
+	0x70, //  ### 
+	0x48, //  #  #
+	0x48, //  #  #
+	0x70, //  ### 
+	0x00, //      
+	0x00, //      
+
+	// U+042B 'Ы'
+	0x042B,
+	0x88, // #   #
+	0x88, // #   #
+	0xE8, // ### #
+	0xA8, // # # #
+	0xA8, // # # #
+	0xE8, // ### #
+	0x00, //      
+	0x00, //      
+
+	// U+042C 'Ь'
+	0x042C,
+	0x80, // #    
+	0x80, // #    
+	0xF0, // #### 
+	0x88, // #   #
+	0x88, // #   #
+	0xF0, // #### 
+	0x00, //      
+	0x00, //      
+
+	// U+042D 'Э'
+	0x042D,
+	0x70, //  ### 
+	0x88, // #   #
+	0x38, //   ###
+	0x08, //     #
+	0x88, // #   #
+	0x70, //  ### 
+	0x00, //      
+	0x00, //      
+
+	// U+042E 'Ю'
+	0x042E,
+	0xB0, // # ## 
+	0xA8, // # # #
+	0xE8, // ### #
+	0xA8, // # # #
+	0xA8, // # # #
+	0xB0, // # ## 
+	0x00, //      
+	0x00, //      
+
+	// U+042F 'Я'
+	0x042F,
+	0x78, //  ####
+	0x88, // #   #
+	0x78, //  ####
+	0x28, //   # #
+	0x48, //  #  #
+	0x88, // #   #
+	0x00, //      
+	0x00, //      
+
+	// U+20AC '€'
+	0x20AC,
+	0x38, //   ###
+	0x40, //  #   
+	0xF0, // #### 
+	0x40, //  #   
+	0xF0, // #### 
+	0x38, //   ###
+	0x00, //      
+	0x00, //      
+
+};
+
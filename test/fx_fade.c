@@ -0,0 +1,129 @@
+/*=========================================================================
+
+  Pico7219
+
+  fx_fade.c
+
+  Checks pico7219_fx on the host, from the SPI traffic that the host
+  build prints. A fade is ticked and flushed frame by frame, and the
+  intensity register that each module latches is decoded from the
+  traffic: the first frame must show the "from" level, and each later
+  one the next step, ending at "to". Then a wipe is started, and the
+  virtual chain length changed under it, after which the wipe must
+  stop, rather than read its target with the wrong layout.
+
+  The traffic is written to a temporary file, and the results to
+  stderr.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pico7219/pico7219.h>
+#include <pico7219/pico7219_fx.h>
+
+#define CHAIN_LEN 4
+#define CS 17
+#define INTENSITY_REG 0x0A
+#define FROM 3
+#define TO 11
+#define TICKS 8
+
+// The intensity that each module has latched, -1 if none yet
+static int intensity[CHAIN_LEN];
+
+/** Latch the intensity words in the SPI traffic written to the file
+    since *offset, and move *offset past it. The last word of a
+    transaction stays in the module nearest the Pico, module 0. */
+static void decode_traffic (const char *path, long *offset)
+  {
+  fflush (stdout);
+  FILE *f = fopen (path, "r");
+  if (!f) return;
+  fseek (f, *offset, SEEK_SET);
+  char line[100];
+  unsigned hi, lo;
+  int pin, level, n = 0;
+  uint16_t words[CHAIN_LEN];
+  while (fgets (line, sizeof (line), f))
+    {
+    if (sscanf (line, "SPI write %x %x", &hi, &lo) == 2)
+      {
+      if (n == CHAIN_LEN)
+        memmove (words, words + 1, (--n) * sizeof (words[0]));
+      words[n++] = (hi << 8) | lo;
+      }
+    else if (sscanf (line, "Set GPIO %d = %d", &pin, &level) == 2 &&
+             pin == CS && level)
+      {
+      for (int i = 0; i < n; i++)
+        {
+        uint16_t w = words[n - 1 - i];
+        if ((w >> 8) == INTENSITY_REG) intensity[i] = w & 0x0F;
+        }
+      n = 0;
+      }
+    }
+  *offset = ftell (f);
+  fclose (f);
+  }
+
+int main (void)
+  {
+  char path[] = "/tmp/fx_fadeXXXXXX";
+  int fd = mkstemp (path);
+  if (fd < 0) return 1;
+  close (fd);
+  if (!freopen (path, "w", stdout)) return 1;
+  long offset = 0;
+
+  struct Pico7219 *display = pico7219_create (PICO_SPI_0, 1000000, 19, 18,
+    CS, CHAIN_LEN, FALSE);
+  if (!display) return 1;
+  pico7219_set_virtual_chain_length (display, CHAIN_LEN);
+  pico7219_set_intensity (display, 15);
+  pico7219_flush (display);
+  struct Pico7219Fx *fx = pico7219_fx_create (display);
+  if (!fx) return 1;
+
+  int errors = 0;
+  pico7219_fx_fade (fx, FROM, TO, TICKS);
+  for (int t = 0; t <= TICKS; t++)
+    {
+    for (int i = 0; i < CHAIN_LEN; i++) intensity[i] = -1;
+    decode_traffic (path, &offset);
+    pico7219_fx_tick (fx);
+    pico7219_flush (display);
+    decode_traffic (path, &offset);
+    int want = FROM + (TO - FROM) * t / TICKS;
+    for (int i = 0; i < CHAIN_LEN; i++)
+      {
+      if (intensity[i] == want) continue;
+      fprintf (stderr, "Frame %d, module %d: intensity %d, expected %d\n",
+        t, i, intensity[i], want);
+      errors++;
+      }
+    }
+  fprintf (stderr, "Fade checked\n");
+
+  // A wipe, with the virtual chain shortened after its first step
+  static uint8_t target[PICO7219_ROWS * CHAIN_LEN];
+  memset (target, 0xFF, sizeof (target));
+  pico7219_fx_wipe (fx, target, PICO7219_FX_WIPE_UP, 1);
+  pico7219_fx_tick (fx);
+  pico7219_set_virtual_chain_length (display, CHAIN_LEN / 2);
+  if (pico7219_fx_tick (fx))
+    {
+    fprintf (stderr, "The wipe went on after the virtual chain changed\n");
+    errors++;
+    }
+  fprintf (stderr, "Wipe checked\n");
+
+  pico7219_fx_destroy (fx);
+  pico7219_destroy (display, FALSE);
+  remove (path);
+  return errors != 0;
+  }
@@ -0,0 +1,188 @@
+/*=========================================================================
+
+  Pico7219
+
+  gray_levels.c
+
+  Checks pico7219_gray on the host, from the SPI traffic that the host
+  build prints, not from the library's own copy of the rows. For each
+  depth, every pixel is given a pseudo-random level, and the traffic
+  after each tick is decoded into the row registers of each module, as
+  a chain of MAX7219s would latch it. Over one grayscale frame, each
+  LED must be lit for as many ticks as its level, and
+  pico7219_gray_estimate_levels() must agree. Then the virtual chain
+  length is changed, which tick must not act on, and the next
+  pico7219_gray_set_pixel() must resize the image, after which the
+  levels must again be right.
+
+  The traffic is written to a temporary file, and the results to
+  stderr.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pico7219/pico7219.h>
+#include <pico7219/pico7219_gray.h>
+
+#define CHAIN_LEN 4
+#define CS 17
+#define WIDTH (PICO7219_COLS * CHAIN_LEN)
+#define SHUTDOWN_REG 0x0C
+
+// The row and shutdown registers of each module, as latched so far
+static uint8_t regs[CHAIN_LEN][16];
+
+static uint32_t seed = 1;
+
+/** A pseudo-random number from 0 to n - 1. */
+static int next (int n)
+  {
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 8) % n;
+  }
+
+/** Latch the SPI traffic written to the file since *offset into
+    regs[], and move *offset past it. The last word of a transaction
+    stays in the module nearest the Pico, module 0. */
+static void decode_traffic (const char *path, long *offset)
+  {
+  fflush (stdout);
+  FILE *f = fopen (path, "r");
+  if (!f) return;
+  fseek (f, *offset, SEEK_SET);
+  char line[100];
+  unsigned hi, lo;
+  int pin, level, n = 0;
+  uint16_t words[CHAIN_LEN];
+  while (fgets (line, sizeof (line), f))
+    {
+    if (sscanf (line, "SPI write %x %x", &hi, &lo) == 2)
+      {
+      if (n == CHAIN_LEN)
+        memmove (words, words + 1, (--n) * sizeof (words[0]));
+      words[n++] = (hi << 8) | lo;
+      }
+    else if (sscanf (line, "Set GPIO %d = %d", &pin, &level) == 2 &&
+             pin == CS && level)
+      {
+      for (int i = 0; i < n; i++)
+        {
+        uint16_t w = words[n - 1 - i];
+        regs[i][(w >> 8) & 0x0F] = w & 0xFF;
+        }
+      n = 0;
+      }
+    }
+  *offset = ftell (f);
+  fclose (f);
+  }
+
+/** Whether the LED at col, row is lit, according to regs[]. */
+static BOOL lit (int col, int row)
+  {
+  const uint8_t *r = regs[col / 8];
+  return r[SHUTDOWN_REG] && (r[row + 1] & (1 << (col % 8)));
+  }
+
+/** Run one grayscale frame of ticks, and compare each LED's on-time,
+    and the estimate, with the levels set. Returns the number of
+    pixels that are wrong. */
+static int check_frame (struct Pico7219Gray *gray, int depth,
+        const char *path, long *offset,
+        uint8_t expected[PICO7219_ROWS][WIDTH])
+  {
+  static uint8_t on[PICO7219_ROWS][WIDTH];
+  static uint8_t estimate[PICO7219_ROWS * WIDTH];
+  memset (on, 0, sizeof (on));
+  // Anything before this frame is latched, but not counted
+  decode_traffic (path, offset);
+  for (int t = 0; t < (1 << depth) - 1; t++)
+    {
+    pico7219_gray_tick (gray);
+    decode_traffic (path, offset);
+    for (int row = 0; row < PICO7219_ROWS; row++)
+      for (int col = 0; col < WIDTH; col++)
+        on[row][col] += lit (col, row);
+    }
+  pico7219_gray_estimate_levels (gray, estimate);
+  decode_traffic (path, offset);
+
+  int errors = 0;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    for (int col = 0; col < WIDTH; col++)
+      {
+      uint8_t want = expected[row][col];
+      if (on[row][col] == want && estimate[row * WIDTH + col] == want)
+        continue;
+      if (errors++ < 5)
+        fprintf (stderr, "Depth %d, row %d, col %d: level %d, lit for %d "
+          "ticks, estimated %d\n", depth, row, col, want, on[row][col],
+          estimate[row * WIDTH + col]);
+      }
+  return errors;
+  }
+
+int main (void)
+  {
+  char path[] = "/tmp/gray_levelsXXXXXX";
+  int fd = mkstemp (path);
+  if (fd < 0) return 1;
+  close (fd);
+  if (!freopen (path, "w", stdout)) return 1;
+  long offset = 0;
+
+  struct Pico7219 *display = pico7219_create (PICO_SPI_0, 1000000, 19, 18,
+    CS, CHAIN_LEN, FALSE);
+  if (!display) return 1;
+  pico7219_set_virtual_chain_length (display, CHAIN_LEN);
+
+  static uint8_t expected[PICO7219_ROWS][WIDTH];
+  int errors = 0;
+  for (int depth = PICO7219_GRAY_MIN_DEPTH; 
+         depth <= PICO7219_GRAY_MAX_DEPTH; depth++)
+    {
+    struct Pico7219Gray *gray = pico7219_gray_create (display, depth);
+    if (!gray) return 1;
+    for (int row = 0; row < PICO7219_ROWS; row++)
+      for (int col = 0; col < WIDTH; col++)
+        {
+        expected[row][col] = next (1 << depth);
+        pico7219_gray_set_pixel (gray, row, col, expected[row][col]);
+        }
+    // Start part of the way through a frame
+    for (int t = next (1 << depth); t > 0; t--)
+      pico7219_gray_tick (gray);
+    errors += check_frame (gray, depth, path, &offset, expected);
+
+    // A longer virtual chain: tick must leave the display alone until
+    //   the image has been resized, and then show it as before; the
+    //   pixel set in the new part is off the display
+    pico7219_set_virtual_chain_length (display, CHAIN_LEN + 1);
+    decode_traffic (path, &offset);
+    for (int t = 0; t < (1 << depth); t++)
+      pico7219_gray_tick (gray);
+    fflush (stdout);
+    long before = offset;
+    decode_traffic (path, &offset);
+    if (offset != before)
+      {
+      fprintf (stderr, "Depth %d: tick drew before the image was "
+        "resized\n", depth);
+      errors++;
+      }
+    pico7219_gray_set_pixel (gray, 0, WIDTH, 1);
+    errors += check_frame (gray, depth, path, &offset, expected);
+    pico7219_set_virtual_chain_length (display, CHAIN_LEN);
+
+    pico7219_gray_destroy (gray);
+    fprintf (stderr, "Depth %d checked\n", depth);
+    }
+
+  pico7219_destroy (display, FALSE);
+  remove (path);
+  return errors != 0;
+  }
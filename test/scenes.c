@@ -0,0 +1,209 @@
+/*=========================================================================
+
+  Pico7219
+
+  scenes.c
+
+  Draws one of a set of fixed scenes with the host build of the
+  library, for comparison with the golden images in test/golden/. The
+  host build prints its SPI traffic, which emu7219 turns back into the
+  image that the LEDs would show, for example
+
+    scenes scroll | emu7219 -g golden/scroll.pbm
+
+  Each scene exercises one part of the library, so that a faster
+  version of it can be checked against the current one pixel for
+  pixel. To make a new golden image, after checking the output with
+  "emu7219 -p", use "emu7219 -o golden/name.pbm".
+
+  Usage: scenes name
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include <pico7219/pico7219.h>
+#include <pico7219/pico7219_font.h>
+#include <pico7219/pico7219_field.h>
+
+// The font, compiled from font8.c by the fontc tool at build time
+extern const struct Pico7219Font font8;
+
+#define MOSI 19
+#define SCK 18
+#define CS 17
+#define CHAIN_LEN 4
+
+#define TEXT "Pico7219!"
+
+// A blink period long enough for a flush to finish in one half of it
+#define BLINK_PERIOD_US 200000
+
+/** Text on a virtual chain twice as long as the display. */
+static void scene_text (struct Pico7219 *p)
+  {
+  pico7219_set_virtual_chain_length (p, 2 * CHAIN_LEN);
+  pico7219_draw_text (p, &font8, 1, TEXT, TRUE);
+  }
+
+/** The text, scrolled part of the way off the display. */
+static void scene_scroll (struct Pico7219 *p)
+  {
+  scene_text (p);
+  for (int i = 0; i < 13; i++)
+    pico7219_scroll (p, FALSE);
+  }
+
+/** The text, scrolled far enough to wrap round the virtual chain. */
+static void scene_scroll_wrap (struct Pico7219 *p)
+  {
+  scene_text (p);
+  for (int i = 0; i < 50; i++)
+    pico7219_scroll (p, TRUE);
+  }
+
+/** A virtual chain shorter than the display: the rest stays dark. */
+static void scene_short (struct Pico7219 *p)
+  {
+  pico7219_set_virtual_chain_length (p, CHAIN_LEN / 2);
+  pico7219_fill_rect (p, 0, 0, PICO7219_COLS * CHAIN_LEN,
+    PICO7219_ROWS, TRUE, FALSE);
+  pico7219_fill_rect (p, 3, 2, 6, 4, FALSE, FALSE);
+  pico7219_scroll (p, TRUE);
+  pico7219_flush (p);
+  }
+
+/** A bar graph, with bars of every height. */
+static void scene_bars (struct Pico7219 *p)
+  {
+  static const uint8_t heights[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 3 };
+  pico7219_set_virtual_chain_length (p, CHAIN_LEN);
+  pico7219_draw_bars (p, 1, heights, sizeof (heights), 2, 1, TRUE);
+  }
+
+/** Wait for the first part of the lit or the dark half of the blink
+    period. */
+static void wait_blink (BOOL off)
+  {
+  uint64_t start = off ? BLINK_PERIOD_US / 2 : 0;
+  uint64_t phase;
+  do
+    phase = pico7219_time_us () % BLINK_PERIOD_US;
+  while (phase < start || phase >= start + BLINK_PERIOD_US / 4);
+  }
+
+/** Text with a blinking rectangle, flushed in the dark half of the
+    blink period, so that the blinking pixels are off. */
+static void scene_blink (struct Pico7219 *p)
+  {
+  pico7219_set_virtual_chain_length (p, CHAIN_LEN);
+  pico7219_draw_text (p, &font8, 0, "Blink", FALSE);
+  pico7219_fill_rect (p, 24, 0, 8, 8, TRUE, FALSE);
+  pico7219_set_blink_rect (p, 8, 0, 20, 5, TRUE);
+  pico7219_set_blink_period (p, BLINK_PERIOD_US);
+  wait_blink (TRUE);
+  pico7219_flush (p);
+  }
+
+/** A fixed label, and a zone showing text from beyond the end of the
+    display, part-way through it. */
+static void scene_zones (struct Pico7219 *p)
+  {
+  pico7219_set_virtual_chain_length (p, 3 * CHAIN_LEN);
+  pico7219_draw_text (p, &font8, 0, "Z:", FALSE);
+  int w = pico7219_draw_text (p, &font8, PICO7219_COLS * CHAIN_LEN,
+    TEXT, FALSE);
+  int zone = pico7219_zone_create (p, 10, 22,
+    PICO7219_COLS * CHAIN_LEN, w);
+  pico7219_zone_set_offset (p, zone, 7, TRUE);
+  }
+
+/** A zone showing text from beyond the end of the display, with part
+    of the text blinking. It is flushed in the lit half of the blink
+    period, then in the dark half, which must send the rows that the
+    zone shows blinking pixels in, though the visible part of the
+    virtual chain has none. */
+static void scene_zone_blink (struct Pico7219 *p)
+  {
+  pico7219_set_virtual_chain_length (p, 3 * CHAIN_LEN);
+  int w = pico7219_draw_text (p, &font8, PICO7219_COLS * CHAIN_LEN,
+    TEXT, FALSE);
+  pico7219_zone_create (p, 0, PICO7219_COLS * CHAIN_LEN,
+    PICO7219_COLS * CHAIN_LEN, w);
+  pico7219_set_blink_rect (p, PICO7219_COLS * CHAIN_LEN + 8, 2, 16, 4, 
+    TRUE);
+  pico7219_set_blink_period (p, BLINK_PERIOD_US);
+  wait_blink (FALSE);
+  pico7219_flush (p);
+  wait_blink (TRUE);
+  pico7219_flush (p);
+  }
+
+/** A text field in the top half of a lit display, four rows high from
+    row 4, with one cell changed after the first drawing. The bottom 
+    rows of each glyph must sit in the field, and nothing outside it 
+    may change. */
+static void scene_field (struct Pico7219 *p)
+  {
+  static struct Pico7219Field field;
+  pico7219_set_virtual_chain_length (p, CHAIN_LEN);
+  pico7219_fill_rect (p, 0, 0, PICO7219_COLS * CHAIN_LEN, PICO7219_ROWS,
+    TRUE, FALSE);
+  pico7219_field_init (&field, p, &font8, 2, 4, 4, 6, 4);
+  pico7219_field_set (&field, "12:3", FALSE);
+  pico7219_field_set (&field, "12:4", TRUE);
+  }
+
+/** Text, then a dark frame, which idle mode turns into shutdown, then
+    the five control register steps of background refresh. Refresh
+    must leave the chain shut down, not wake it with the text still in
+    its row registers. */
+static void scene_idle_refresh (struct Pico7219 *p)
+  {
+  pico7219_set_virtual_chain_length (p, CHAIN_LEN);
+  pico7219_set_idle (p, TRUE);
+  pico7219_draw_text (p, &font8, 0, TEXT, TRUE);
+  pico7219_switch_off_all (p, TRUE);
+  for (int i = 0; i < 5; i++)
+    pico7219_refresh_step (p);
+  }
+
+static const struct
+  {
+  const char *name;
+  void (*draw) (struct Pico7219 *p);
+  BOOL reverse;
+  } scenes[] =
+  {
+  { "text", scene_text, FALSE },
+  { "scroll", scene_scroll, FALSE },
+  // The same scroll on a bit-reversed chain must give the same image
+  { "scroll_reversed", scene_scroll, TRUE },
+  { "scroll_wrap", scene_scroll_wrap, FALSE },
+  { "short", scene_short, FALSE },
+  { "bars", scene_bars, FALSE },
+  { "blink", scene_blink, FALSE },
+  { "zones", scene_zones, FALSE },
+  { "zone_blink", scene_zone_blink, FALSE },
+  { "field", scene_field, FALSE },
+  { "idle_refresh", scene_idle_refresh, FALSE },
+  };
+
+int main (int argc, char **argv)
+  {
+  for (size_t i = 0; argc == 2 && i < sizeof (scenes) / sizeof (scenes[0]);
+       i++)
+    {
+    if (strcmp (argv[1], scenes[i].name)) continue;
+    struct Pico7219 *p = pico7219_create (PICO_SPI_0, 1000000, MOSI, SCK,
+      CS, CHAIN_LEN, scenes[i].reverse);
+    if (!p) return 1;
+    // The display is not destroyed, since that would shut it down, 
+    //   and leave the last frame dark
+    scenes[i].draw (p);
+    return 0;
+    }
+  fprintf (stderr, "Usage: %s name\n", argv[0]);
+  return 1;
+  }
@@ -0,0 +1,212 @@
+/*=========================================================================
+
+  Pico7219
+
+  stream_loopback.c
+
+  Checks and times the frame stream protocol through a pipe, on the
+  host. A child process encodes a sequence of pseudo-random frames,
+  each changing a few bytes of the last, with a keyframe every so
+  often, and writes them to a pipe; in the middle of the run it also
+  damages one frame between each pair of keyframes, by dropping, 
+  changing or inserting a byte, a sync or escape byte in some cases.
+  The parent reads the pipe as stdin with pico7219_stream_poll_stdio(),
+  as a program on the Pico would read USB stdio.
+
+  Each time a frame is shown, the display, as it was sent at the last
+  flush, must be exactly one of the frames sent, and never an earlier
+  one than was last shown -- the framebuffer itself may already hold
+  part of the next frame, which the decoder writes as it arrives. The
+  last frame must be shown; and, outside the damaged part, no frame
+  may be dropped. Returns a non-zero status if any of this fails.
+  Then it reports the rate at which frames were decoded. The host
+  build of the library prints its SPI traffic, so stdout is discarded,
+  and the results are written to stderr.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <pico7219/pico7219.h>
+#include <pico7219/pico7219_stream.h>
+
+// A whole chain, so that every byte of a frame is on the display
+#define CHAIN_LEN PICO7219_MAX_CHAIN
+#define FRAMES 3000
+#define KEY_INTERVAL 50
+#define DAMAGE_START 1000
+#define DAMAGE_END 2000
+// The frame in each key interval that is damaged
+#define DAMAGE_AT 10
+
+static uint8_t frames[FRAMES][PICO7219_ROWS * CHAIN_LEN];
+
+static uint32_t seed = 1;
+
+/** A pseudo-random number from 0 to n - 1. */
+static int next (int n)
+  {
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 8) % n;
+  }
+
+/** Make the frames. Some bytes are sync and escape bytes, so that the
+    escapes are exercised. */
+static void make_frames (void)
+  {
+  static const uint8_t special[] =
+    { PICO7219_STREAM_SYNC, PICO7219_STREAM_ESC, 0x5E };
+  for (int i = 0; i < FRAMES; i++)
+    {
+    if (i) memcpy (frames[i], frames[i - 1], sizeof (frames[i]));
+    int changes = i % 100 == 0 ? 100 : 1 + next (8);
+    for (int j = 0; j < changes; j++)
+      {
+      uint8_t v = next (4) ? next (256) : special[next (3)];
+      int pos = next (sizeof (frames[i]));
+      // Every frame differs from the one before
+      if (j == 0 && frames[i][pos] == v) v ^= 1;
+      frames[i][pos] = v;
+      }
+    }
+  }
+
+/** The child: write the encoded frames to fd, damaging some. */
+static void send_frames (int fd)
+  {
+  static uint8_t out[PICO7219_STREAM_MAX_FRAME (CHAIN_LEN) + 1];
+  FILE *f = fdopen (fd, "wb");
+  if (!f) _exit (1);
+  for (int i = 0; i < FRAMES; i++)
+    {
+    const uint8_t *prev = i % KEY_INTERVAL ? frames[i - 1] : NULL;
+    int n = pico7219_stream_encode (prev, frames[i], CHAIN_LEN, out);
+    if (i >= DAMAGE_START && i < DAMAGE_END && 
+        i % KEY_INTERVAL == DAMAGE_AT)
+      {
+      int pos = next (n);
+      switch (i / KEY_INTERVAL % 4)
+        {
+        case 0: // Drop a byte
+          memmove (out + pos, out + pos + 1, n - pos - 1);
+          n--;
+          break;
+        case 1: // Change a byte
+          out[pos] ^= 1 << next (8);
+          break;
+        case 2: // Insert a sync byte
+          memmove (out + pos + 1, out + pos, n - pos);
+          out[pos] = PICO7219_STREAM_SYNC;
+          n++;
+          break;
+        default: // Insert an escape
+          memmove (out + pos + 1, out + pos, n - pos);
+          out[pos] = PICO7219_STREAM_ESC;
+          n++;
+        }
+      }
+    fwrite (out, 1, n, f);
+    }
+  fclose (f);
+  _exit (0);
+  }
+
+/** Find the frame that the display shows, starting at from. Returns 
+    -1 if it shows none of them. */
+static int shown_frame (struct Pico7219 *display, int from)
+  {
+  uint8_t shown[PICO7219_ROWS][PICO7219_MAX_CHAIN];
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    pico7219_get_display_row (display, row, shown[row]);
+  for (int i = from; i < FRAMES; i++)
+    {
+    int row;
+    for (row = 0; row < PICO7219_ROWS; row++)
+      if (memcmp (shown[row], frames[i] + row * CHAIN_LEN, CHAIN_LEN))
+        break;
+    if (row == PICO7219_ROWS) return i;
+    }
+  return -1;
+  }
+
+int main (void)
+  {
+  struct Pico7219 *display = pico7219_create (PICO_SPI_0, 1000000,
+    19, 18, 17, CHAIN_LEN, FALSE);
+  if (!display) return 1;
+  make_frames ();
+
+  int fds[2];
+  if (pipe (fds)) return 1;
+  fflush (stdout);
+  pid_t pid = fork ();
+  if (pid < 0) return 1;
+  if (pid == 0)
+    {
+    close (fds[0]);
+    send_frames (fds[1]);
+    }
+  close (fds[1]);
+  if (dup2 (fds[0], STDIN_FILENO) < 0) return 1;
+  close (fds[0]);
+  if (!freopen ("/dev/null", "w", stdout)) return 1;
+
+  struct Pico7219StreamDecoder dec;
+  pico7219_stream_init (&dec, display);
+  int last = 0, n, errors = 0, clean_gaps = 0;
+  uint64_t start = pico7219_time_us ();
+  while ((n = pico7219_stream_poll_stdio (&dec)) >= 0)
+    {
+    if (n == 0) continue;
+    // Several frames may have been shown in one read, so the display
+    //   holds the last of them
+    int frame = shown_frame (display, last);
+    if (frame < 0)
+      {
+      if (errors++ < 10)
+        fprintf (stderr, "After frame %d, the display shows no frame "
+          "that was sent\n", last);
+      continue;
+      }
+    // Only the frames from a damaged one to the next keyframe may be
+    //   lost, so if any were, the frames shown must start at a keyframe
+    int key = frame - frame % KEY_INTERVAL;
+    if (frame - last > n && !(key > last && frame - key < n &&
+        key > DAMAGE_START && key <= DAMAGE_END))
+      clean_gaps++;
+    last = frame;
+    }
+  uint64_t elapsed_us = pico7219_time_us () - start;
+  int status;
+  waitpid (pid, &status, 0);
+
+  uint32_t decoded, bytes, dropped;
+  pico7219_stream_get_stats (&dec, &decoded, &bytes, &dropped);
+  fprintf (stderr, "%d frames sent, %u shown, %u dropped, %u bytes\n",
+    FRAMES, decoded, dropped, bytes);
+  if (last != FRAMES - 1)
+    {
+    fprintf (stderr, "The last frame shown was %d\n", last);
+    errors++;
+    }
+  if (clean_gaps)
+    {
+    fprintf (stderr, "%d frames were lost outside the damaged part\n",
+      clean_gaps);
+    errors++;
+    }
+  if (!dropped)
+    {
+    fprintf (stderr, "No damaged frame was detected\n");
+    errors++;
+    }
+  if (!WIFEXITED (status) || WEXITSTATUS (status)) errors++;
+  if (elapsed_us)
+    fprintf (stderr, "  %.0f frames/s, %.0f kB/s\n",
+      1e6 * decoded / elapsed_us, 1e3 * bytes / elapsed_us);
+  pico7219_destroy (display, FALSE);
+  return errors != 0;
+  }
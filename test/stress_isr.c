@@ -0,0 +1,104 @@
+/*=========================================================================
+
+  Pico7219
+
+  stress_isr.c
+
+  Stress test for the interrupt update queue, on the host. A second
+  thread stands in for the interrupt handler, and queues a long
+  sequence of pixel changes with pico7219_isr_set_pixel(), yielding
+  and retrying whenever the queue is full, while the main thread 
+  applies the queue as fast as it can, as the flush would. The
+  virtual chain is wider than 256 pixels, so that columns that don't
+  fit in a byte are exercised, and some changes are outside it, and
+  must be dropped. At the end, the virtual chain must hold exactly the
+  last change queued for each pixel. Build with -fsanitize=thread to
+  check the memory ordering as well.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <pico7219/pico7219.h>
+
+#define CHAIN_LEN 4
+#define VIRTUAL_LEN 40
+#define WIDTH (PICO7219_COLS * VIRTUAL_LEN)
+#define CHANGES 500000
+
+static struct Pico7219 *display;
+
+// The last change queued for each pixel, kept by the producer
+static uint8_t expected[PICO7219_ROWS][WIDTH];
+
+static int done;
+static unsigned long retries;
+
+/** The producer: queue CHANGES pseudo-random pixel changes. */
+static void *producer (void *arg)
+  {
+  (void)arg;
+  uint32_t seed = 12345;
+  for (int i = 0; i < CHANGES; i++)
+    {
+    seed = seed * 1103515245 + 12345;
+    uint8_t row = (seed >> 8) & 7;
+    // A few columns past the end of the virtual chain
+    uint16_t col = (seed >> 12) % (WIDTH + 16);
+    BOOL on = (seed >> 30) & 1;
+    // Let the consumer run, in case there is only one CPU
+    while (!pico7219_isr_set_pixel (display, row, col, on))
+      {
+      retries++;
+      sched_yield ();
+      }
+    if (col < WIDTH) expected[row][col] = on;
+    }
+  __atomic_store_n (&done, 1, __ATOMIC_RELEASE);
+  return NULL;
+  }
+
+int main (void)
+  {
+  display = pico7219_create (PICO_SPI_0, 1000000, 19, 18, 17,
+    CHAIN_LEN, FALSE);
+  if (!display || !pico7219_set_virtual_chain_length (display, VIRTUAL_LEN))
+    return 1;
+
+  pthread_t thread;
+  if (pthread_create (&thread, NULL, producer, NULL)) return 1;
+  unsigned long applies = 0;
+  while (!__atomic_load_n (&done, __ATOMIC_ACQUIRE))
+    {
+    pico7219_isr_apply (display);
+    applies++;
+    sched_yield ();
+    }
+  pthread_join (thread, NULL);
+  pico7219_isr_apply (display);
+
+  int errors = 0;
+  for (int row = 0; row < PICO7219_ROWS; row++)
+    {
+    const uint8_t *data = pico7219_get_row_buffer (display, row);
+    for (int col = 0; col < WIDTH; col++)
+      {
+      int lit = (data[col / 8] >> (col % 8)) & 1;
+      if (lit != expected[row][col])
+        {
+        if (errors < 10)
+          printf ("Pixel %d,%d is %d, expected %d\n", col, row, lit,
+            expected[row][col]);
+        errors++;
+        }
+      }
+    }
+  printf ("%d changes, %lu applies, %lu retries on a full queue, "
+    "%d errors\n", CHANGES, applies, retries, errors);
+  pico7219_destroy (display, FALSE);
+  return errors != 0;
+  }
+
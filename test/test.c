@@ -13,10 +13,10 @@
   =========================================================================*/
 #include <string.h>
 #include <pico7219/pico7219.h> // The library's header
+#include <pico7219/pico7219_font.h> 
 
-extern uint8_t font8_table[];
-extern uint8_t font8_first;
-extern uint8_t font8_last;
+// The font, compiled from font8.c by the fontc tool at build time
+extern const struct Pico7219Font font8;
 
 //
 // Pin assignments
@@ -41,55 +41,21 @@ extern uint8_t font8_last;
 
 typedef struct Pico7219 Pico7219; // Shorter than "struct Pico7219..."
 
-// Draw a character to the library. Note that the width of the "virtual
-// display" can be much longer than the physical module chain, and
-// off-display elements can later be scrolled into view. However, it's
+// Draw a string of text on the (virtual) display. Note that the width of 
+// the "virtual display" can be much longer than the physical module chain,
+// and off-display elements can later be scrolled into view. However, it's
 // the job of the application, not the library, to size the virtual
 // display sufficiently to fit all the text in.
-//
-// chr is an offset in the font table, which starts with character 32 (space).
-// It isn't an ASCII character.
-void draw_character (Pico7219 *pico7219, uint8_t chr, int x_offset, 
-       BOOL flush)
-  {
-  for (int i = 0; i < 8; i++) // row
-    {
-    // The font elements are one byte wide even though, as its an 8x5 font,
-    //   only the top five bits of each byte are used.
-    uint8_t v = font8_table[8 * chr + i];
-    for (int j = 0; j < 8; j++) // column
-      {
-      int sel = 1 << j;
-      if (sel & v)
-        pico7219_switch_on (pico7219, 7 - i, 7- j + x_offset, FALSE);
-      }
-    }
-  if (flush)
-    pico7219_flush (pico7219);
-  }
-
-// Draw a string of text on the (virtual) display. This function assumes
-// that the library has already been configured to provide a virtual
-// chain of LED modules that is long enough to fit all the text onto.
 void draw_string (Pico7219 *pico7219, const char *s, BOOL flush)
   {
-  int x = 0;
-  while (*s)
-    {
-    draw_character (pico7219, *s - ' ', x, FALSE); 
-    s++;
-    x += 6;
-    }
-  if (flush)
-    pico7219_flush (pico7219);
+  pico7219_draw_text (pico7219, &font8, 0, s, flush);
   }
 
-// Get the number of horizontal pixels that a string will take. Since each
-// font element is five pixels wide, and there is one pixel between each
-// character, we just multiply the string length by 6.
+// Get the number of horizontal pixels that a string will take. The font
+// is proportional, so this depends on the characters in the string.
 int get_string_length_pixels (const char *s)
   {
-  return strlen (s) * 6;
+  return pico7219_font_text_width (&font8, s);
   }
 
 // Get the number of 8x8 LED modules that would be needed to accomodate the
@@ -0,0 +1,326 @@
+/*=========================================================================
+
+  Pico7219
+
+  emu7219.c
+
+  A host tool that emulates a chain of MAX7219 matrix modules, driven
+  by the output of a program built against the host (non-Pico) version
+  of the library. The host build prints each chip-select change and
+  each 16-bit SPI word; this tool shifts the words through the chain,
+  latches them on the rising edge of chip-select as the real chips do,
+  and shows what the LEDs would display. Lines of input that are not
+  library output are ignored.
+
+  Usage: program | emu7219 [-n chain_len] [-r] [-c cs_pin] [-a] [-p]
+                           [-o output.pbm] [-g golden.pbm]
+
+  -n   Number of modules. By default this is taken from the number of
+       words in the first transaction.
+  -r   The modules are wired in reverse bit order, as in
+       pico7219_create(..., TRUE). The image is always drawn in the
+       order of the library's columns, so that a program gives the
+       same image either way.
+  -c   Only follow the chain whose chip-select is on this GPIO pin.
+  -p   Preview the display on the terminal, using ANSI colours.
+  -o   Write the display as a plain PBM image, one pixel per LED, with
+       module 0 -- the one nearest the Pico -- on the left, and row 7
+       at the top, the same way up as text drawn with a font.
+  -a   Write or preview the display after every transaction that
+       changes it, not just at the end. Since the library writes one
+       row per transaction, a flush will usually give several frames.
+       With -o, the file name is used as a prefix, to which a frame
+       number and ".pbm" are added.
+  -g   Compare the last frame with a PBM image, and exit with a non-zero
+       status if any pixel differs. With a set of saved images, this
+       allows changes to the library to be checked against the
+       output of an earlier version, pixel for pixel.
+
+  The shutdown, display test, scan limit and decode registers are
+  emulated; intensity is not, since the output is monochrome.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define EMU_ROWS 8
+#define EMU_MAX_CHAIN 64
+#define EMU_WIDTH (8 * EMU_MAX_CHAIN)
+
+#define EMU_DECODE_REG 0x09
+#define EMU_SCAN_LIMIT_REG 0x0B
+#define EMU_SHUTDOWN_REG 0x0C
+#define EMU_TEST_REG 0x0F
+
+// Segments A-G (bits 6-0) for Code B values 0-15
+static const uint8_t emu_codeb[16] =
+  {
+  0x7E, 0x30, 0x6D, 0x79, 0x33, 0x5B, 0x5F, 0x70,
+  0x7F, 0x7B, 0x01, 0x4F, 0x37, 0x0E, 0x67, 0x00
+  };
+
+// The state of one MAX7219
+struct EmuChip
+  {
+  uint16_t shift; // Shift register: the last word clocked in
+  uint8_t regs[16];
+  };
+
+struct Emu
+  {
+  struct EmuChip chips[EMU_MAX_CHAIN];
+  int chain_len; // 0 until known
+  int reverse;
+  int words; // Words clocked in during the current transaction
+  uint8_t image[EMU_ROWS][EMU_WIDTH]; // 1 for a lit LED, top row first
+  };
+
+/** Clock one word into the chain. The word goes into the chip nearest
+    the input, and each chip's old word moves on to the next chip. */
+static void emu_shift (struct Emu *emu, uint16_t word)
+  {
+  for (int i = EMU_MAX_CHAIN - 1; i > 0; i--)
+    emu->chips[i].shift = emu->chips[i - 1].shift;
+  emu->chips[0].shift = word;
+  emu->words++;
+  }
+
+/** Chip-select has gone high: every chip stores the word in its shift
+    register in the register that the word addresses. */
+static void emu_latch (struct Emu *emu)
+  {
+  if (emu->words == 0) return;
+  if (emu->chain_len == 0)
+    emu->chain_len = emu->words < EMU_MAX_CHAIN ? emu->words : EMU_MAX_CHAIN;
+  for (int i = 0; i < emu->chain_len; i++)
+    {
+    struct EmuChip *chip = &emu->chips[i];
+    chip->regs[(chip->shift >> 8) & 0x0F] = chip->shift & 0xFF;
+    }
+  emu->words = 0;
+  }
+
+/** Work out which LEDs are lit. Returns 1 if the image has changed. */
+static int emu_render (struct Emu *emu)
+  {
+  int changed = 0;
+  for (int m = 0; m < emu->chain_len; m++)
+    {
+    const uint8_t *regs = emu->chips[m].regs;
+    for (int row = 0; row < EMU_ROWS; row++)
+      {
+      uint8_t v = regs[row + 1];
+      if (regs[EMU_DECODE_REG] & (1 << row))
+        v = (v & 0x80) | emu_codeb[v & 0x0F];
+      if (!regs[EMU_SHUTDOWN_REG] || row > (regs[EMU_SCAN_LIMIT_REG] & 7))
+        v = 0;
+      if (regs[EMU_TEST_REG] & 1)
+        v = 0xFF;
+      for (int k = 0; k < 8; k++)
+        {
+        int bit = emu->reverse ? 7 - k : k;
+        uint8_t lit = (v >> bit) & 1;
+        // Row 7 is the top of the display, as for fonts and images
+        uint8_t *p = &emu->image[EMU_ROWS - 1 - row][8 * m + k];
+        if (*p != lit) changed = 1;
+        *p = lit;
+        }
+      }
+    }
+  return changed;
+  }
+
+/** Write the image as a plain (text) PBM file. Returns 0 on success. */
+static int emu_write_pbm (const struct Emu *emu, const char *filename)
+  {
+  FILE *f = fopen (filename, "w");
+  if (!f)
+    {
+    perror (filename);
+    return -1;
+    }
+  int width = 8 * emu->chain_len;
+  fprintf (f, "P1\n%d %d\n", width, EMU_ROWS);
+  for (int row = 0; row < EMU_ROWS; row++)
+    {
+    for (int x = 0; x < width; x++)
+      fprintf (f, x ? " %d" : "%d", emu->image[row][x]);
+    fprintf (f, "\n");
+    }
+  fclose (f);
+  return 0;
+  }
+
+/** Show the image on the terminal. */
+static void emu_preview (const struct Emu *emu)
+  {
+  for (int row = 0; row < EMU_ROWS; row++)
+    {
+    for (int x = 0; x < 8 * emu->chain_len; x++)
+      {
+      if (emu->image[row][x])
+        printf ("\033[91m●\033[0m");
+      else
+        printf ("\033[90m·\033[0m");
+      }
+    printf ("\n");
+    }
+  printf ("\n");
+  }
+
+/** Read the next number from a PBM file, skipping whitespace and
+    comments. Returns -1 at the end of the file. */
+static int emu_pbm_number (FILE *f, int digit)
+  {
+  int c;
+  while ((c = fgetc (f)) != EOF)
+    {
+    if (c == '#')
+      while ((c = fgetc (f)) != EOF && c != '\n');
+    else if (c >= '0' && c <= '9')
+      break;
+    }
+  if (c == EOF) return -1;
+  // Pixels in a plain PBM need not be separated by whitespace
+  if (digit) return c - '0';
+  int n = c - '0';
+  while ((c = fgetc (f)) >= '0' && c <= '9')
+    n = n * 10 + c - '0';
+  return n;
+  }
+
+/** Compare the image with a plain PBM file, and report differences.
+    Returns the number of pixels that differ, or -1 on error. */
+static int emu_compare_pbm (const struct Emu *emu, const char *filename)
+  {
+  FILE *f = fopen (filename, "r");
+  if (!f)
+    {
+    perror (filename);
+    return -1;
+    }
+  char magic[3] = {0};
+  int width = -1, height = -1;
+  if (fread (magic, 1, 2, f) == 2 && strcmp (magic, "P1") == 0)
+    {
+    width = emu_pbm_number (f, 0);
+    height = emu_pbm_number (f, 0);
+    }
+  if (width != 8 * emu->chain_len || height != EMU_ROWS)
+    {
+    fprintf (stderr, "%s: not a plain PBM image of %dx%d\n", filename,
+      8 * emu->chain_len, EMU_ROWS);
+    fclose (f);
+    return -1;
+    }
+  int diffs = 0;
+  for (int row = 0; row < EMU_ROWS; row++)
+    {
+    for (int x = 0; x < width; x++)
+      {
+      int v = emu_pbm_number (f, 1);
+      if (v != emu->image[row][x])
+        {
+        if (diffs < 10)
+          fprintf (stderr, "%s: pixel %d,%d is %d, expected %d\n",
+            filename, x, EMU_ROWS - 1 - row, emu->image[row][x], v);
+        diffs++;
+        }
+      }
+    }
+  fclose (f);
+  return diffs;
+  }
+
+int main (int argc, char **argv)
+  {
+  static struct Emu emu;
+  int cs = -1;
+  int all = 0;
+  int preview = 0;
+  const char *output = NULL;
+  const char *golden = NULL;
+  int opt;
+  while ((opt = getopt (argc, argv, "n:rc:apo:g:")) != -1)
+    {
+    switch (opt)
+      {
+      case 'n': emu.chain_len = atoi (optarg); break;
+      case 'r': emu.reverse = 1; break;
+      case 'c': cs = atoi (optarg); break;
+      case 'a': all = 1; break;
+      case 'p': preview = 1; break;
+      case 'o': output = optarg; break;
+      case 'g': golden = optarg; break;
+      default: argc = 0; // Force the usage message
+      }
+    }
+  if (argc - optind != 0 || emu.chain_len < 0 ||
+      emu.chain_len > EMU_MAX_CHAIN)
+    {
+    fprintf (stderr, "Usage: %s [-n chain_len] [-r] [-c cs_pin] [-a] [-p] "
+      "[-o output.pbm] [-g golden.pbm]\n", argv[0]);
+    return 1;
+    }
+
+  char line[256];
+  int selected = 0; // TRUE while our chip-select is low
+  int frames = 0;
+  while (fgets (line, sizeof (line), stdin))
+    {
+    int pin, level;
+    unsigned hi, lo;
+    if (sscanf (line, "Set GPIO %d = %d", &pin, &level) == 2)
+      {
+      if (cs >= 0 && pin != cs) continue;
+      if (level && selected)
+        {
+        emu_latch (&emu);
+        if (emu_render (&emu) && all)
+          {
+          if (preview) emu_preview (&emu);
+          if (output)
+            {
+            char filename[300];
+            snprintf (filename, sizeof (filename), "%s%04d.pbm",
+              output, frames);
+            if (emu_write_pbm (&emu, filename)) return 1;
+            }
+          frames++;
+          }
+        }
+      selected = !level;
+      }
+    else if (sscanf (line, "SPI write %x %x", &hi, &lo) == 2)
+      {
+      if (selected) emu_shift (&emu, (hi & 0xFF) << 8 | (lo & 0xFF));
+      }
+    }
+
+  if (emu.chain_len == 0)
+    {
+    fprintf (stderr, "%s: no display output in the input\n", argv[0]);
+    return 1;
+    }
+  if (!all)
+    {
+    if (preview) emu_preview (&emu);
+    if (output && emu_write_pbm (&emu, output)) return 1;
+    }
+  if (golden)
+    {
+    int diffs = emu_compare_pbm (&emu, golden);
+    if (diffs != 0)
+      {
+      if (diffs > 0) fprintf (stderr, "%s: %d pixels differ\n", golden, diffs);
+      return 2;
+      }
+    }
+  return 0;
+  }
+
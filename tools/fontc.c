@@ -0,0 +1,268 @@
+/*=========================================================================
+ 
+  Pico7219
+
+  fontc.c
+
+  A host tool that compiles a bitmap font into the packed format used
+  by pico7219_font.h. The input is a C source file containing a table 
+  of eight bytes per glyph, one byte per row from the top, with the 
+  leftmost pixel in the MSB -- the layout of test/font8.c. Only the
+  hexadecimal constants between the first pair of braces are read,
+  and comments are ignored, so the same tool works for any font 
+  written in that layout.
+
+  Usage: fontc [-s spacing] [-b blank_width] [-x extra.c] 
+               input.c name first output.c
+
+  "name" is the name of the struct Pico7219Font to generate, and
+  "first" is the character code of the first glyph in the table.
+  Glyphs for other characters, anywhere in the Unicode Basic 
+  Multilingual Plane, can be read from a second file with -x. In that
+  file each glyph is its code point followed by its eight rows, as in
+  test/font8_ext.c. These glyphs are sorted by code point, so that the
+  library can find them by binary search.
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define FONTC_ROWS 8
+#define FONTC_BLOCK 16 // Must match PICO7219_FONT_BLOCK
+#define FONTC_MAX_GLYPHS 1024
+#define FONTC_MAX_DENSE 256
+
+/** Read the glyph table from a C source file. Returns the number of
+    values read into table, or -1 on error. */
+static int fontc_read_table (const char *filename, int *table, int max)
+  {
+  FILE *f = fopen (filename, "r");
+  if (!f)
+    {
+    perror (filename);
+    return -1;
+    }
+  int n = 0;
+  int depth = 0;
+  int c, prev = 0;
+  while ((c = fgetc (f)) != EOF)
+    {
+    if (prev == '/' && c == '/')
+      {
+      while ((c = fgetc (f)) != EOF && c != '\n');
+      prev = 0;
+      continue;
+      }
+    if (prev == '/' && c == '*')
+      {
+      prev = 0;
+      while ((c = fgetc (f)) != EOF && !(prev == '*' && c == '/')) 
+        prev = c;
+      prev = 0;
+      continue;
+      }
+    if (c == '{') depth++;
+    else if (c == '}' && depth > 0) break;
+    else if (depth > 0 && prev == '0' && (c == 'x' || c == 'X'))
+      {
+      unsigned v;
+      if (fscanf (f, "%x", &v) == 1)
+        {
+        if (n == max)
+          {
+          fprintf (stderr, "%s: table too large\n", filename);
+          fclose (f);
+          return -1;
+          }
+        table[n++] = v;
+        }
+      }
+    prev = c;
+    }
+  fclose (f);
+  return n;
+  }
+
+/** Convert one glyph from rows to columns. Column c of the result has
+    bit r set if the LED in row r (counting up from the bottom) is on. */
+static void fontc_rows_to_columns (const uint8_t *rows, uint8_t *cols)
+  {
+  for (int c = 0; c < 8; c++)
+    {
+    cols[c] = 0;
+    for (int i = 0; i < FONTC_ROWS; i++)
+      if (rows[i] & (0x80 >> c)) cols[c] |= 1 << (FONTC_ROWS - 1 - i);
+    }
+  }
+
+/** Sort the extra glyphs by code point. Each entry is the code point
+    followed by the rows. There are not many, so a simple insertion
+    sort will do. */
+static void fontc_sort_extra (int *extra, int count)
+  {
+  int stride = 1 + FONTC_ROWS;
+  for (int i = 1; i < count; i++)
+    {
+    int tmp[1 + FONTC_ROWS];
+    memcpy (tmp, extra + i * stride, sizeof (tmp));
+    int j = i - 1;
+    while (j >= 0 && extra[j * stride] > tmp[0])
+      {
+      memcpy (extra + (j + 1) * stride, extra + j * stride, sizeof (tmp));
+      j--;
+      }
+    memcpy (extra + (j + 1) * stride, tmp, sizeof (tmp));
+    }
+  }
+
+/** Write an array as C source. */
+static void fontc_write_array (FILE *out, const char *type, 
+        const char *name, const char *suffix, const int *v, int n, 
+        int digits)
+  {
+  int per_line = 48 / (digits + 2);
+  fprintf (out, "static const %s %s_%s[%d] =\n  {", type, name, suffix, 
+    n ? n : 1);
+  for (int i = 0; i < n; i++)
+    fprintf (out, "%s%s0x%0*x", i ? "," : "", i % per_line ? " " : "\n  ",
+      digits, v[i]);
+  if (n == 0) fprintf (out, "\n  0");
+  fprintf (out, "\n  };\n\n");
+  }
+
+int main (int argc, char **argv)
+  {
+  int spacing = 1;
+  int blank_width = 2;
+  const char *extra_file = NULL;
+  int opt;
+  while ((opt = getopt (argc, argv, "s:b:x:")) != -1)
+    {
+    switch (opt)
+      {
+      case 's': spacing = atoi (optarg); break;
+      case 'b': blank_width = atoi (optarg); break;
+      case 'x': extra_file = optarg; break;
+      default: argc = 0; // Force the usage message
+      }
+    }
+  if (argc - optind != 4)
+    {
+    fprintf (stderr, "Usage: %s [-s spacing] [-b blank_width] "
+      "[-x extra.c] input.c name first output.c\n", argv[0]);
+    return 1;
+    }
+  const char *input = argv[optind];
+  const char *name = argv[optind + 1];
+  int first = atoi (argv[optind + 2]);
+  const char *output = argv[optind + 3];
+
+  static int table[FONTC_MAX_DENSE * FONTC_ROWS];
+  int n = fontc_read_table (input, table, FONTC_MAX_DENSE * FONTC_ROWS);
+  if (n < 0) return 1;
+  if (n == 0 || n % FONTC_ROWS != 0)
+    {
+    fprintf (stderr, "%s: table size %d is not a multiple of %d\n",
+      input, n, FONTC_ROWS);
+    return 1;
+    }
+  int count = n / FONTC_ROWS;
+  if (first + count > FONTC_MAX_DENSE)
+    {
+    fprintf (stderr, "%s: glyphs run past character 255\n", input);
+    return 1;
+    }
+
+  static int extra[(FONTC_MAX_GLYPHS - FONTC_MAX_DENSE) * (1 + FONTC_ROWS)];
+  int extra_count = 0;
+  if (extra_file)
+    {
+    n = fontc_read_table (extra_file, extra, 
+      sizeof (extra) / sizeof (extra[0]));
+    if (n < 0) return 1;
+    if (n % (1 + FONTC_ROWS) != 0)
+      {
+      fprintf (stderr, "%s: table size %d is not a multiple of %d\n",
+        extra_file, n, 1 + FONTC_ROWS);
+      return 1;
+      }
+    extra_count = n / (1 + FONTC_ROWS);
+    fontc_sort_extra (extra, extra_count);
+    for (int i = 0; i < extra_count; i++)
+      {
+      int code = extra[i * (1 + FONTC_ROWS)];
+      if (code > 0xFFFF || (i > 0 && code == extra[(i - 1) * (1 + FONTC_ROWS)]))
+        {
+        fprintf (stderr, "%s: bad or duplicate code point U+%04X\n", 
+          extra_file, code);
+        return 1;
+        }
+      }
+    }
+
+  // Glyphs are numbered with the dense range first, then the extras
+  int glyphs = count + extra_count;
+  static int columns[FONTC_MAX_GLYPHS * 8];
+  static int offsets[FONTC_MAX_GLYPHS + 1];
+  static int blocks[FONTC_MAX_GLYPHS / FONTC_BLOCK + 1];
+  static int codes[FONTC_MAX_GLYPHS];
+  int total = 0;
+  for (int g = 0; g <= glyphs; g++)
+    {
+    if (g % FONTC_BLOCK == 0) blocks[g / FONTC_BLOCK] = total;
+    offsets[g] = total - blocks[g / FONTC_BLOCK];
+    if (g == glyphs) break;
+
+    uint8_t rows[FONTC_ROWS];
+    const int *src;
+    if (g < count)
+      src = table + g * FONTC_ROWS;
+    else
+      {
+      src = extra + (g - count) * (1 + FONTC_ROWS);
+      codes[g - count] = *src++;
+      }
+    for (int i = 0; i < FONTC_ROWS; i++) rows[i] = src[i];
+
+    // Trim blank columns from both sides
+    uint8_t cols[8];
+    fontc_rows_to_columns (rows, cols);
+    int left = 0, right = 7;
+    while (left <= right && !cols[left]) left++;
+    while (right >= left && !cols[right]) right--;
+    for (int c = left; c <= right; c++) columns[total++] = cols[c];
+    }
+
+  FILE *out = fopen (output, "w");
+  if (!out)
+    {
+    perror (output);
+    return 1;
+    }
+  fprintf (out, "// Generated by fontc from %s%s%s. Do not edit.\n\n", 
+    input, extra_file ? " and " : "", extra_file ? extra_file : "");
+  fprintf (out, "#include <pico7219/pico7219_font.h>\n\n");
+  fprintf (out, "// %d glyphs, %d column bytes, %d index bytes\n\n", 
+    glyphs, total, 
+    glyphs + 1 + 2 * (glyphs / FONTC_BLOCK + 1) + 2 * extra_count);
+  fontc_write_array (out, "uint8_t", name, "columns", columns, total, 2);
+  fontc_write_array (out, "uint16_t", name, "blocks", blocks, 
+    glyphs / FONTC_BLOCK + 1, 4);
+  fontc_write_array (out, "uint8_t", name, "offsets", offsets, 
+    glyphs + 1, 2);
+  fontc_write_array (out, "uint16_t", name, "codes", codes, 
+    extra_count, 4);
+  fprintf (out, "const struct Pico7219Font %s =\n  {\n", name);
+  fprintf (out, "  %d, %d, %d, %d, %d,\n", first, count, spacing, 
+    blank_width, extra_count);
+  fprintf (out, "  %s_codes, %s_blocks, %s_offsets, %s_columns\n  };\n", 
+    name, name, name, name);
+  fclose (out);
+  return 0;
+  }
+
@@ -0,0 +1,353 @@
+/*=========================================================================
+
+  Pico7219
+
+  imgc.c
+
+  A host tool that converts a PBM image into the format used by
+  pico7219_image.h, so that it can be compiled into a program and
+  drawn with no conversion at runtime. The image is stored as rows of
+  bytes laid out exactly like the library's virtual chain -- bit 0 of
+  byte 0 is column 0 -- with the top row of the image in display row 7,
+  as for fonts.
+
+  An image can be a sprite sheet, or the frames of an animation: it is
+  cut into frames of the width given with -w and eight rows high,
+  taken left to right and then top to bottom. With -z, each frame is
+  compressed with a simple run-length encoding, which suits animations
+  with large blank or solid areas; the library decodes it straight
+  into the virtual chain.
+
+  With -a, the frames are written instead as a struct 
+  Pico7219Animation, in which each frame after the first is stored as
+  the rows that differ from the frame before, XORed with it and 
+  run-length encoded. A frame is stored whole, as a key frame, if that
+  is no larger, or with -k every n frames. -t sets the time for which
+  each frame is shown, in milliseconds.
+
+  Both plain (P1) and raw (P4) PBM files can be read. In PBM a 1 is
+  black, which is taken to be a lit LED, so that images can be drawn
+  black-on-white in any editor; -i inverts this. Other formats, such as
+  PNG, can be converted to PBM with the netpbm tools, for example
+  "pngtopnm image.png | ppmtopgm | pgmtopbm > image.pbm".
+
+  Usage: imgc [-w frame_width] [-z] [-i] [-a] [-k n] [-t ms] 
+              input.pbm name output.c
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#define IMGC_ROWS 8
+#define IMGC_MAX_WIDTH 4096
+#define IMGC_MAX_HEIGHT 1024
+
+// Frame types in an animation. These must match pico7219_image.h
+#define IMGC_ANIM_KEY 0x00
+#define IMGC_ANIM_DELTA 0x01
+
+/** Read the next number from a PBM header, skipping whitespace and
+    comments. Returns -1 on error. */
+static int imgc_pbm_number (FILE *f)
+  {
+  int c;
+  while ((c = fgetc (f)) != EOF)
+    {
+    if (c == '#')
+      while ((c = fgetc (f)) != EOF && c != '\n');
+    else if (c >= '0' && c <= '9')
+      break;
+    }
+  if (c == EOF) return -1;
+  int n = c - '0';
+  while ((c = fgetc (f)) >= '0' && c <= '9')
+    n = n * 10 + c - '0';
+  // A raw PBM has exactly one whitespace character after the header,
+  //   which this has just read
+  return n;
+  }
+
+/** Read a PBM file into pixels[], one byte per pixel, 1 for black.
+    Returns the pixels, which the caller must free, or NULL on error. */
+static uint8_t *imgc_read_pbm (const char *filename, int *width,
+        int *height)
+  {
+  FILE *f = fopen (filename, "rb");
+  if (!f)
+    {
+    perror (filename);
+    return NULL;
+    }
+  char magic[3] = {0};
+  int w = -1, h = -1;
+  if (fread (magic, 1, 2, f) == 2 && magic[0] == 'P' &&
+      (magic[1] == '1' || magic[1] == '4'))
+    {
+    w = imgc_pbm_number (f);
+    h = imgc_pbm_number (f);
+    }
+  if (w <= 0 || h <= 0 || w > IMGC_MAX_WIDTH || h > IMGC_MAX_HEIGHT)
+    {
+    fprintf (stderr, "%s: not a PBM image, or too large\n", filename);
+    fclose (f);
+    return NULL;
+    }
+  uint8_t *pixels = malloc (w * h);
+  if (!pixels)
+    {
+    fclose (f);
+    return NULL;
+    }
+  int byte = 0;
+  for (int y = 0; y < h; y++)
+    {
+    for (int x = 0; x < w; x++)
+      {
+      int c;
+      if (magic[1] == '1')
+        {
+        while ((c = fgetc (f)) != EOF && c != '0' && c != '1')
+          if (c == '#') while ((c = fgetc (f)) != EOF && c != '\n');
+        pixels[y * w + x] = c == '1';
+        }
+      else
+        {
+        // Raw rows are padded to whole bytes, MSB first
+        if (x % 8 == 0) byte = fgetc (f);
+        c = byte;
+        pixels[y * w + x] = (byte >> (7 - x % 8)) & 1;
+        }
+      if (c == EOF)
+        {
+        fprintf (stderr, "%s: image data is truncated\n", filename);
+        free (pixels);
+        fclose (f);
+        return NULL;
+        }
+      }
+    }
+  fclose (f);
+  *width = w;
+  *height = h;
+  return pixels;
+  }
+
+/** Run-length encode n bytes into out, returning the encoded length.
+    A control byte c below 0x80 is followed by c + 1 literal bytes;
+    otherwise the following byte is repeated c - 0x7E times (2-129).
+    out must have room for n + n / 128 + 1 bytes. */
+static int imgc_rle (const uint8_t *in, int n, uint8_t *out)
+  {
+  int len = 0;
+  int i = 0;
+  while (i < n)
+    {
+    int run = 1;
+    while (i + run < n && run < 129 && in[i + run] == in[i]) run++;
+    if (run >= 2)
+      {
+      out[len++] = 0x7E + run;
+      out[len++] = in[i];
+      i += run;
+      continue;
+      }
+    // Collect literals until a run of at least two starts
+    int start = i;
+    while (i < n && i - start < 128 &&
+           !(i + 1 < n && in[i + 1] == in[i]))
+      i++;
+    out[len++] = i - start - 1;
+    memcpy (out + len, in + start, i - start);
+    len += i - start;
+    }
+  return len;
+  }
+
+/** Encode one animation frame into out, returning the encoded length.
+    If prev is NULL, this is a key frame, and every row is stored; 
+    otherwise only the rows that differ from prev are stored, XORed 
+    with it. */
+static int imgc_anim_frame (const uint8_t *raw, const uint8_t *prev, 
+        int stride, uint8_t *out)
+  {
+  uint8_t row_bytes[256];
+  int len = 2;
+  out[0] = prev ? IMGC_ANIM_DELTA : IMGC_ANIM_KEY;
+  out[1] = 0;
+  for (int row = 0; row < IMGC_ROWS; row++)
+    {
+    int changed = !prev;
+    for (int i = 0; i < stride; i++)
+      {
+      row_bytes[i] = raw[row * stride + i];
+      if (prev) row_bytes[i] ^= prev[row * stride + i];
+      if (row_bytes[i]) changed = 1;
+      }
+    if (!changed) continue;
+    out[1] |= 1 << row;
+    len += imgc_rle (row_bytes, stride, out + len);
+    }
+  return len;
+  }
+
+/** Write a byte array as C source. */
+static void imgc_write_array (FILE *out, const char *type, const char *name,
+        const char *suffix, const uint32_t *v, int n, int digits)
+  {
+  int per_line = 48 / (digits + 2);
+  fprintf (out, "static const %s %s_%s[%d] =\n  {", type, name, suffix, n);
+  for (int i = 0; i < n; i++)
+    fprintf (out, "%s%s0x%0*x", i ? "," : "", i % per_line ? " " : "\n  ",
+      digits, v[i]);
+  fprintf (out, "\n  };\n\n");
+  }
+
+int main (int argc, char **argv)
+  {
+  int frame_width = 0;
+  int rle = 0;
+  int invert = 0;
+  int anim = 0;
+  int key_interval = 0;
+  int frame_ms = 100;
+  int opt;
+  while ((opt = getopt (argc, argv, "w:ziak:t:")) != -1)
+    {
+    switch (opt)
+      {
+      case 'w': frame_width = atoi (optarg); break;
+      case 'z': rle = 1; break;
+      case 'i': invert = 1; break;
+      case 'a': anim = 1; break;
+      case 'k': key_interval = atoi (optarg); break;
+      case 't': frame_ms = atoi (optarg); break;
+      default: argc = 0; // Force the usage message
+      }
+    }
+  if (argc - optind != 3)
+    {
+    fprintf (stderr, "Usage: %s [-w frame_width] [-z] [-i] [-a] [-k n] "
+      "[-t ms] input.pbm name output.c\n", argv[0]);
+    return 1;
+    }
+  const char *input = argv[optind];
+  const char *name = argv[optind + 1];
+  const char *output = argv[optind + 2];
+
+  int width, height;
+  uint8_t *pixels = imgc_read_pbm (input, &width, &height);
+  if (!pixels) return 1;
+  if (frame_width <= 0) frame_width = width;
+  if (width % frame_width != 0 || height % IMGC_ROWS != 0 ||
+      frame_width > 8 * 255)
+    {
+    fprintf (stderr, "%s: %dx%d image can't be cut into %dx%d frames\n",
+      input, width, height, frame_width, IMGC_ROWS);
+    return 1;
+    }
+  int across = width / frame_width;
+  int frames = across * (height / IMGC_ROWS);
+  int stride = (frame_width + 7) / 8;
+  int frame_size = IMGC_ROWS * stride;
+
+  // Worst case for RLE is slightly larger than the raw frame, and an
+  //   animation frame has two bytes of header and RLE for each row
+  int max_packed = 2 + IMGC_ROWS * (stride + stride / 128 + 1);
+  uint32_t *data = malloc (sizeof (uint32_t) * frames * max_packed);
+  uint32_t *offsets = malloc (sizeof (uint32_t) * (frames + 1));
+  uint8_t *raw = malloc (frame_size);
+  uint8_t *prev = malloc (frame_size);
+  uint8_t *packed = malloc (max_packed);
+  uint8_t *delta = malloc (max_packed);
+  if (!data || !offsets || !raw || !prev || !packed || !delta) return 1;
+  int keys = 0;
+
+  int total = 0;
+  for (int f = 0; f < frames; f++)
+    {
+    int x0 = (f % across) * frame_width;
+    int y0 = (f / across) * IMGC_ROWS;
+    memset (raw, 0, frame_size);
+    for (int row = 0; row < IMGC_ROWS; row++)
+      {
+      // The top row of the image is display row 7
+      const uint8_t *src = pixels + (y0 + IMGC_ROWS - 1 - row) * width + x0;
+      for (int x = 0; x < frame_width; x++)
+        {
+        if (src[x] != invert) raw[row * stride + x / 8] |= 1 << (x % 8);
+        }
+      }
+    offsets[f] = total;
+    if (anim)
+      {
+      int n = imgc_anim_frame (raw, NULL, stride, packed);
+      if (f > 0 && !(key_interval > 0 && f % key_interval == 0))
+        {
+        int d = imgc_anim_frame (raw, prev, stride, delta);
+        if (d < n)
+          {
+          memcpy (packed, delta, d);
+          n = d;
+          }
+        }
+      if (packed[0] == IMGC_ANIM_KEY) keys++;
+      for (int i = 0; i < n; i++) data[total++] = packed[i];
+      memcpy (prev, raw, frame_size);
+      }
+    else if (rle)
+      {
+      int n = imgc_rle (raw, frame_size, packed);
+      for (int i = 0; i < n; i++) data[total++] = packed[i];
+      }
+    else
+      {
+      for (int i = 0; i < frame_size; i++) data[total++] = raw[i];
+      }
+    }
+  offsets[frames] = total;
+
+  FILE *out = fopen (output, "w");
+  if (!out)
+    {
+    perror (output);
+    return 1;
+    }
+  fprintf (out, "// Generated by imgc from %s. Do not edit.\n\n", input);
+  fprintf (out, "#include <pico7219/pico7219_image.h>\n\n");
+  fprintf (out, "// %d frames of %dx%d, %d data bytes (%d uncompressed)\n\n",
+    frames, frame_width, IMGC_ROWS, total, frames * frame_size);
+  imgc_write_array (out, "uint8_t", name, "data", data, total, 2);
+  if (anim)
+    {
+    fprintf (out, "// %d key frames\n", keys);
+    fprintf (out, "const struct Pico7219Animation %s =\n  {\n", name);
+    fprintf (out, "  %d, %d, %d, NULL, %s_data\n  };\n", frame_width, 
+      frames, frame_ms, name);
+    }
+  else
+    {
+    if (rle)
+      imgc_write_array (out, "uint32_t", name, "offsets", offsets,
+        frames + 1, 8);
+    fprintf (out, "const struct Pico7219Image %s =\n  {\n", name);
+    fprintf (out, "  %d, %d, %d,\n", frame_width, frames,
+      rle ? 1 : 0);
+    fprintf (out, "  %s_data, %s%s\n  };\n", name, rle ? name : "NULL",
+      rle ? "_offsets" : "");
+    }
+  fclose (out);
+  free (pixels);
+  free (data);
+  free (offsets);
+  free (raw);
+  free (prev);
+  free (packed);
+  free (delta);
+  return 0;
+  }
+
@@ -0,0 +1,183 @@
+/*=========================================================================
+
+  Pico7219
+
+  stream7219.c
+
+  A host tool that encodes a sequence of PBM images as a
+  pico7219_stream frame stream, on stdout, for example to be sent to a
+  Pico over USB stdio, or piped into a program that decodes it. Each
+  image is one frame, and must be eight rows high; the top row of the
+  image is display row 7, as for fonts and imgc. Images narrower than
+  a whole number of modules are padded with unlit columns.
+
+  The images are read from the files named on the command line, or
+  from stdin, and a file may hold several images one after another, as
+  the netpbm tools write them. In PBM a 1 is black, which is taken to
+  be a lit LED; -i inverts this. Each frame is sent as a delta from
+  the one before, or as a keyframe if that is no larger; with -k a
+  keyframe is also sent every n frames, so that a receiver that joins
+  late, or loses data, recovers. -d waits the given number of
+  milliseconds after each frame. A summary of the bytes sent is
+  written to stderr.
+
+  Usage: stream7219 [-k n] [-d ms] [-i] [file.pbm...]
+
+  Copyright (c)2021 Kevin Boone, GPL v3.0
+
+  =========================================================================*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pico7219/pico7219_stream.h>
+
+#define STREAM7219_ROWS 8
+#define STREAM7219_MAX_WIDTH 255
+
+/** Read the next number from a PBM header, skipping whitespace and
+    comments. Returns -1 on error. */
+static int stream7219_pbm_number (FILE *f)
+  {
+  int c;
+  while ((c = fgetc (f)) != EOF)
+    {
+    if (c == '#')
+      while ((c = fgetc (f)) != EOF && c != '\n');
+    else if (c >= '0' && c <= '9')
+      break;
+    }
+  if (c == EOF) return -1;
+  int n = c - '0';
+  while ((c = fgetc (f)) >= '0' && c <= '9')
+    n = n * 10 + c - '0';
+  return n;
+  }
+
+/** Read the next PBM image from f into frame[], in the virtual chain
+    layout. Returns the width of the frame in bytes, 0 at the end of
+    the file, or -1 on error. */
+static int stream7219_read_pbm (FILE *f, const char *name, BOOL invert,
+        uint8_t *frame)
+  {
+  int c;
+  // Skip any whitespace between images
+  while ((c = fgetc (f)) == ' ' || c == '\t' || c == '\r' || c == '\n');
+  if (c == EOF) return 0;
+  int type = fgetc (f);
+  if (c != 'P' || (type != '1' && type != '4'))
+    {
+    fprintf (stderr, "%s: not a PBM image\n", name);
+    return -1;
+    }
+  int w = stream7219_pbm_number (f);
+  int h = stream7219_pbm_number (f);
+  int width = (w + 7) / 8;
+  if (w <= 0 || h != STREAM7219_ROWS || width > STREAM7219_MAX_WIDTH)
+    {
+    fprintf (stderr, "%s: images must be %d rows high, and at most %d "
+      "columns wide\n", name, STREAM7219_ROWS, 8 * STREAM7219_MAX_WIDTH);
+    return -1;
+    }
+  memset (frame, 0, STREAM7219_ROWS * width);
+  int byte = 0;
+  for (int y = 0; y < h; y++)
+    {
+    uint8_t *row = frame + (STREAM7219_ROWS - 1 - y) * width;
+    for (int x = 0; x < w; x++)
+      {
+      int bit;
+      if (type == '1')
+        {
+        while ((c = fgetc (f)) != EOF && c != '0' && c != '1')
+          if (c == '#') while ((c = fgetc (f)) != EOF && c != '\n');
+        bit = c == '1';
+        }
+      else
+        {
+        // Raw rows are padded to whole bytes, MSB first
+        if (x % 8 == 0) byte = c = fgetc (f);
+        bit = (byte >> (7 - x % 8)) & 1;
+        }
+      if (c == EOF)
+        {
+        fprintf (stderr, "%s: image data is truncated\n", name);
+        return -1;
+        }
+      if (bit != invert) row[x / 8] |= 1 << (x % 8);
+      }
+    }
+  return width;
+  }
+
+/** Show a usage message. */
+static void stream7219_usage (const char *argv0)
+  {
+  fprintf (stderr, "Usage: %s [-k n] [-d ms] [-i] [file.pbm...]\n", argv0);
+  }
+
+int main (int argc, char **argv)
+  {
+  int key_interval = 0;
+  int delay_ms = 0;
+  BOOL invert = FALSE;
+  int opt;
+  while ((opt = getopt (argc, argv, "k:d:i")) != -1)
+    {
+    switch (opt)
+      {
+      case 'k': key_interval = atoi (optarg); break;
+      case 'd': delay_ms = atoi (optarg); break;
+      case 'i': invert = TRUE; break;
+      default: stream7219_usage (argv[0]); return 1;
+      }
+    }
+
+  static uint8_t frames[2][STREAM7219_ROWS * STREAM7219_MAX_WIDTH];
+  static uint8_t out[PICO7219_STREAM_MAX_FRAME (STREAM7219_MAX_WIDTH)];
+  int last_width = 0;
+  long count = 0, keys = 0, total = 0;
+  int nfiles = argc - optind;
+  for (int i = 0; i < (nfiles ? nfiles : 1); i++)
+    {
+    const char *name = nfiles ? argv[optind + i] : "stdin";
+    FILE *f = nfiles ? fopen (name, "rb") : stdin;
+    if (!f)
+      {
+      perror (name);
+      return 1;
+      }
+    int width;
+    while ((width = stream7219_read_pbm (f, name, invert,
+             frames[count % 2])) > 0)
+      {
+      const uint8_t *cur = frames[count % 2];
+      const uint8_t *prev = frames[(count + 1) % 2];
+      // A change of width, or the key interval, forces a keyframe
+      BOOL key = count == 0 || width != last_width ||
+        (key_interval > 0 && count % key_interval == 0);
+      int n = pico7219_stream_encode (key ? NULL : prev, cur, width, out);
+      if (out[1] == PICO7219_STREAM_KEY) keys++;
+      if (fwrite (out, 1, n, stdout) != (size_t)n)
+        {
+        perror ("stdout");
+        return 1;
+        }
+      fflush (stdout);
+      if (delay_ms) usleep (delay_ms * 1000);
+      last_width = width;
+      total += n;
+      count++;
+      }
+    if (nfiles) fclose (f);
+    if (width < 0) return 1;
+    }
+
+  fprintf (stderr, "%ld frames, %ld keyframes, %ld bytes", count, keys,
+    total);
+  if (count) fprintf (stderr, ", %.1f bytes per frame",
+    (double)total / count);
+  fprintf (stderr, "\n");
+  return 0;
+  }